@@ -5,36 +5,120 @@ writeRatio2=0.75
 writeRatio3=1.00
 
 numThreads=1
-for numThreads in 1 2 4 8 16 32
+for policy in none compact scatter node
 do
-    for numOP in 1000000 2000000 4000000 8000000
+    for numThreads in 1 2 4 8 16 32
     do
-        echo "./bin/l_queue_test threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"
-        echo "./bin/l_queue_test threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"    >> res/l_queue_result_50.txt
-        { time ./bin/l_queue_test $numThreads $numOP $writeRatio1 ;}                             2>> res/l_queue_result_50.txt
-        echo "-----------------------------------------------------"                              >> res/l_queue_result_50.txt
-
-        echo "./bin/l_queue_test threads: $numThreads, numOP: $numOP, writeRatio $writeRatio2"
-        echo "./bin/l_queue_test threads: $numThreads, numOP: $numOP, writeRatio $writeRatio2"    >> res/l_queue_result_75.txt
-        { time ./bin/l_queue_test $numThreads $numOP $writeRatio2 ;}                             2>> res/l_queue_result_75.txt
-        echo "-----------------------------------------------------"                              >> res/l_queue_result_75.txt
+        for numOP in 1000000 2000000 4000000 8000000
+        do
+            echo "./bin/l_queue_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"
+            echo "./bin/l_queue_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"    >> res/l_queue_result_50_$policy.txt
+            { time ./bin/l_queue_test -a $policy $numThreads $numOP $writeRatio1 ;}                             2>> res/l_queue_result_50_$policy.txt
+            echo "-----------------------------------------------------"                              >> res/l_queue_result_50_$policy.txt
+
+            echo "./bin/l_queue_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio2"
+            echo "./bin/l_queue_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio2"    >> res/l_queue_result_75_$policy.txt
+            { time ./bin/l_queue_test -a $policy $numThreads $numOP $writeRatio2 ;}                             2>> res/l_queue_result_75_$policy.txt
+            echo "-----------------------------------------------------"                              >> res/l_queue_result_75_$policy.txt
+        done
     done
 done
 
 
 numThreads=1
-for numThreads in 1 2 4 8 16 32
+for policy in none compact scatter node
+do
+    for numThreads in 1 2 4 8 16 32
+    do
+        for numOP in 1000000 2000000 4000000 8000000
+        do
+            echo "./bin/lf_queue_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"
+            echo "./bin/lf_queue_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"   >> res/lf_queue_result_50_$policy.txt
+            { time ./bin/lf_queue_test -a $policy $numThreads $numOP $writeRatio1 ; }                           2>> res/lf_queue_result_50_$policy.txt
+            echo "-----------------------------------------------------"                              >> res/lf_queue_result_50_$policy.txt
+
+            echo "./bin/lf_queue_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio2"
+            echo "./bin/lf_queue_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio2"    >> res/lf_queue_result_75_$policy.txt
+            { time ./bin/lf_queue_test -a $policy $numThreads $numOP $writeRatio2 ;}                             2>> res/lf_queue_result_75_$policy.txt
+            echo "-----------------------------------------------------"                               >> res/lf_queue_result_75_$policy.txt
+        done
+    done
+done
+
+
+for policy in none compact scatter node
+do
+    for numThreads in 2 4 8 16 32
+    do
+        for numOP in 1000000 2000000 4000000 8000000
+        do
+            for kind in mpmc mpsc spsc
+            do
+                echo "./bin/lf_queue_test policy: $policy, kind: $kind, threads: $numThreads, numOP: $numOP"
+                echo "./bin/lf_queue_test policy: $policy, kind: $kind, threads: $numThreads, numOP: $numOP"    >> res/lf_queue_${kind}_$policy.txt
+                { time ./bin/lf_queue_test -a $policy -k $kind $numThreads $numOP $writeRatio1 ;}              2>> res/lf_queue_${kind}_$policy.txt
+                echo "-----------------------------------------------------"                                   >> res/lf_queue_${kind}_$policy.txt
+            done
+        done
+    done
+done
+
+
+for policy in none compact scatter node
+do
+    for numThreads in 1 2 4 8 16 32
+    do
+        for numOP in 1000000 2000000 4000000 8000000
+        do
+            for relaxation in 0 1 2 4
+            do
+                echo "./bin/pq_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1, relaxation $relaxation"
+                echo "./bin/pq_test policy: $policy, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1, relaxation $relaxation"    >> res/pq_result_50_c${relaxation}_$policy.txt
+                { time ./bin/pq_test -a $policy -c $relaxation $numThreads $numOP $writeRatio1 ;}                                           2>> res/pq_result_50_c${relaxation}_$policy.txt
+                ./bin/pq_test -a $policy -c $relaxation -e $numThreads 0 $writeRatio1                                                       >> res/pq_result_50_c${relaxation}_$policy.txt
+                echo "-----------------------------------------------------"                                                                 >> res/pq_result_50_c${relaxation}_$policy.txt
+            done
+        done
+    done
+done
+
+
+for policy in none compact scatter node
+do
+    for topology in "-P 1 -C 1" "-P 4 -C 1" "-P 4 -C 4"
+    do
+        for rate in 100000 1000000 0
+        do
+            tag=$(echo "$topology" | tr -d ' -')
+            echo "./bin/l_queue_test policy: $policy, topology: $topology, rate: $rate"
+            echo "./bin/l_queue_test policy: $policy, topology: $topology, rate: $rate"     >> res/l_queue_latency_${tag}_$policy.txt
+            ./bin/l_queue_test -a $policy $topology -R $rate 8 1000000 0                    >> res/l_queue_latency_${tag}_$policy.txt
+            echo "-----------------------------------------------------"                     >> res/l_queue_latency_${tag}_$policy.txt
+
+            echo "./bin/lf_queue_test policy: $policy, topology: $topology, rate: $rate"
+            echo "./bin/lf_queue_test policy: $policy, topology: $topology, rate: $rate"    >> res/lf_queue_latency_${tag}_$policy.txt
+            ./bin/lf_queue_test -a $policy $topology -R $rate 8 1000000 0                   >> res/lf_queue_latency_${tag}_$policy.txt
+            echo "-----------------------------------------------------"                     >> res/lf_queue_latency_${tag}_$policy.txt
+        done
+    done
+done
+
+
+for policy in none compact scatter node
 do
-    for numOP in 1000000 2000000 4000000 8000000
+    for numThreads in 1 2 4 8 16 32
     do
-        echo "./bin/lf_queue_test threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"
-        echo "./bin/lf_queue_test threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"   >> res/lf_queue_result_50.txt
-        { time ./bin/lf_queue_test $numThreads $numOP $writeRatio1 ; }                           2>> res/lf_queue_result_50.txt
-        echo "-----------------------------------------------------"                              >> res/lf_queue_result_50.txt
-
-        echo "./bin/lf_queue_test threads: $numThreads, numOP: $numOP, writeRatio $writeRatio2"
-        echo "./bin/lf_queue_test threads: $numThreads, numOP: $numOP, writeRatio $writeRatio2"    >> res/lf_queue_result_75.txt
-        { time ./bin/lf_queue_test $numThreads $numOP $writeRatio2 ;}                             2>> res/lf_queue_result_75.txt
-        echo "-----------------------------------------------------"                               >> res/lf_queue_result_75.txt
+        for numOP in 1000000 2000000 4000000 8000000
+        do
+            for mode in typed baseline
+            do
+                flag=""
+                if [ $mode = baseline ]; then flag="-b"; fi
+                echo "./bin/lf_tqueue_test policy: $policy, mode: $mode, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"
+                echo "./bin/lf_tqueue_test policy: $policy, mode: $mode, threads: $numThreads, numOP: $numOP, writeRatio $writeRatio1"    >> res/lf_tqueue_result_50_${mode}_$policy.txt
+                { time ./bin/lf_tqueue_test -a $policy $flag $numThreads $numOP $writeRatio1 ;}                                        2>> res/lf_tqueue_result_50_${mode}_$policy.txt
+                echo "-----------------------------------------------------"                                                             >> res/lf_tqueue_result_50_${mode}_$policy.txt
+            done
+        done
     done
 done
@@ -0,0 +1,176 @@
+#define _GNU_SOURCE
+#include "affinity.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#define MAX_NODES 64
+
+typedef struct topology {
+    int num_nodes;
+    int num_cpus;
+    int node_size[MAX_NODES];        /* usable cpus per node */
+    int *node_cpus[MAX_NODES];       /* usable cpus of each node */
+    int compact[CPU_SETSIZE];        /* all usable cpus, node by node */
+    int node_of_cpu[CPU_SETSIZE];
+} topology;
+
+static topology topo;
+static pthread_once_t topo_once = PTHREAD_ONCE_INIT;
+
+
+/* parse a sysfs cpulist such as "0-7,16-23" into a cpu set */
+static void parse_cpulist(const char *s, cpu_set_t *set) {
+    CPU_ZERO(set);
+    while (*s != '\0' && *s != '\n') {
+        char *end;
+        long lo = strtol(s, &end, 10);
+        long hi = lo;
+        if (end == s) {
+            break;
+        }
+        if (*end == '-') {
+            s = end + 1;
+            hi = strtol(s, &end, 10);
+        }
+        for (long c = lo; c <= hi && c < CPU_SETSIZE; c++) {
+            CPU_SET(c, set);
+        }
+        s = (*end == ',') ? end + 1 : end;
+    }
+}
+
+
+static void add_node(const cpu_set_t *node_set, const cpu_set_t *allowed) {
+    int n = topo.num_nodes;
+    int count = 0;
+    topo.node_cpus[n] = (int*) malloc(CPU_SETSIZE * sizeof(int));
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, node_set) && CPU_ISSET(c, allowed)) {
+            topo.node_cpus[n][count++] = c;
+            topo.compact[topo.num_cpus++] = c;
+            topo.node_of_cpu[c] = n;
+        }
+    }
+    if (count == 0) {
+        free(topo.node_cpus[n]);
+        return;
+    }
+    topo.node_size[n] = count;
+    topo.num_nodes++;
+}
+
+
+static void topology_init(void) {
+    cpu_set_t allowed, node_set;
+    char path[64], buffer[4096];
+
+    memset(&topo, 0, sizeof(topology));
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        CPU_SET(0, &allowed);
+    }
+
+    for (int n = 0; n < MAX_NODES; n++) {
+        sprintf(path, "/sys/devices/system/node/node%d/cpulist", n);
+        FILE *fp = fopen(path, "r");
+        if (!fp) {
+            continue;
+        }
+        if (fgets(buffer, sizeof(buffer), fp)) {
+            parse_cpulist(buffer, &node_set);
+            add_node(&node_set, &allowed);
+        }
+        fclose(fp);
+    }
+
+    /* no sysfs topology: one node with every allowed cpu */
+    if (topo.num_nodes == 0) {
+        add_node(&allowed, &allowed);
+    }
+}
+
+
+int affinity_parse(const char *name, affinity_policy *policy, int *numa_node) {
+    pthread_once(&topo_once, topology_init);
+    *numa_node = 0;
+    if (strcmp(name, "none") == 0) {
+        *policy = AFFINITY_NONE;
+    } else if (strcmp(name, "compact") == 0) {
+        *policy = AFFINITY_COMPACT;
+    } else if (strcmp(name, "scatter") == 0) {
+        *policy = AFFINITY_SCATTER;
+    } else if (strncmp(name, "node", 4) == 0) {
+        *policy = AFFINITY_NODE;
+        if (name[4] == ':') {
+            *numa_node = strtol(name + 5, NULL, 10);
+        }
+        if (*numa_node < 0 || *numa_node >= topo.num_nodes) {
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
+const char* affinity_name(affinity_policy policy) {
+    switch (policy) {
+    case AFFINITY_COMPACT: return "compact";
+    case AFFINITY_SCATTER: return "scatter";
+    case AFFINITY_NODE:    return "node";
+    default:               return "none";
+    }
+}
+
+
+int affinity_num_nodes(void) {
+    pthread_once(&topo_once, topology_init);
+    return topo.num_nodes;
+}
+
+
+int affinity_current_node(void) {
+    pthread_once(&topo_once, topology_init);
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return 0;
+    }
+    return topo.node_of_cpu[cpu];
+}
+
+
+/* Pin the calling thread, the tid-th worker, to one cpu chosen by policy.
+ * Threads beyond the available cpus wrap around. */
+int affinity_pin(affinity_policy policy, int numa_node, int tid) {
+    pthread_once(&topo_once, topology_init);
+
+    int cpu;
+    switch (policy) {
+    case AFFINITY_COMPACT:
+        cpu = topo.compact[tid % topo.num_cpus];
+        break;
+    case AFFINITY_SCATTER: {
+        int n = tid % topo.num_nodes;
+        cpu = topo.node_cpus[n][(tid / topo.num_nodes) % topo.node_size[n]];
+        break;
+    }
+    case AFFINITY_NODE:
+        cpu = topo.node_cpus[numa_node][tid % topo.node_size[numa_node]];
+        break;
+    default:
+        return 0;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &set) != 0) {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef MULTICORE_AFFINITY_H
+#define MULTICORE_AFFINITY_H
+
+/* Thread placement policies for the test drivers.
+ * Topology comes from /sys/devices/system/node; machines without it
+ * are treated as a single node holding every cpu we may run on. */
+typedef enum affinity_policy {
+    AFFINITY_NONE,      /* leave placement to the OS / OpenMP runtime */
+    AFFINITY_COMPACT,   /* fill one NUMA node's cpus before the next */
+    AFFINITY_SCATTER,   /* round-robin threads over the NUMA nodes */
+    AFFINITY_NODE,      /* keep every thread on a single NUMA node */
+} affinity_policy;
+
+int affinity_parse(const char *name, affinity_policy *policy, int *numa_node);
+const char* affinity_name(affinity_policy policy);
+int affinity_num_nodes(void);
+int affinity_current_node(void);
+int affinity_pin(affinity_policy policy, int numa_node, int tid);
+
+#endif //MULTICORE_AFFINITY_H
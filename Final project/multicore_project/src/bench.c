@@ -0,0 +1,61 @@
+#define _GNU_SOURCE
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+
+
+long bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+
+/* yields rather than spins: producers may share cpus with consumers */
+void bench_wait_until(long t_ns) {
+    while (bench_now_ns() < t_ns)
+        sched_yield();
+}
+
+
+/* Producers are staggered by one interval so that the offered load is
+ * evenly spaced. */
+long bench_schedule(long start, double rate, int producers, int tid, long k) {
+    if (rate <= 0)
+        return -1;
+    return start + (long) ((k * producers + tid) * 1e9 / rate);
+}
+
+
+static int compare_longs(const void *a, const void *b) {
+    long x = *(const long*) a;
+    long y = *(const long*) b;
+    return (x > y) - (x < y);
+}
+
+
+static long percentile(const long *sorted, long n, double p) {
+    long i = (long) (p * (n - 1));
+    return sorted[i];
+}
+
+
+void bench_report(int producers, int consumers, double rate,
+                  long *lat, long n, long elapsed_ns) {
+    printf("producers: %d, consumers: %d, offered: ", producers, consumers);
+    if (rate > 0)
+        printf("%.0f ops/s", rate);
+    else
+        printf("closed loop");
+    printf(", throughput: %.0f ops/s\n", n * 1e9 / elapsed_ns);
+
+    if (n == 0)
+        return;
+    qsort(lat, n, sizeof(long), compare_longs);
+    printf("latency ns: p50 %ld, p90 %ld, p99 %ld, p99.9 %ld, max %ld\n",
+           percentile(lat, n, 0.50), percentile(lat, n, 0.90),
+           percentile(lat, n, 0.99), percentile(lat, n, 0.999), lat[n - 1]);
+}
@@ -0,0 +1,17 @@
+#ifndef MULTICORE_BENCH_H
+#define MULTICORE_BENCH_H
+
+/* Shared helpers for the producer/consumer modes of the queue drivers.
+ * Times are CLOCK_MONOTONIC nanoseconds. */
+long bench_now_ns(void);
+void bench_wait_until(long t_ns);
+
+/* Send time of a producer's k-th item at rate items/s shared by
+ * producers threads; rate 0 is closed loop and returns -1. */
+long bench_schedule(long start, double rate, int producers, int tid, long k);
+
+/* Sorts lat[0..n) and prints throughput and latency percentiles. */
+void bench_report(int producers, int consumers, double rate,
+                  long *lat, long n, long elapsed_ns);
+
+#endif //MULTICORE_BENCH_H
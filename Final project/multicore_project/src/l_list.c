@@ -1,10 +1,11 @@
 #include "l_list.h"
+#include "pool.h"
 
 #include <string.h>
 #include <omp.h>
 
 node* node_new(int val) {
-    node *new_node = (node*) malloc(sizeof(node));
+    node *new_node = (node*) pool_alloc(sizeof(node));
     if (new_node == NULL) {
 #ifdef DEBUG
         printf("node_new(%d)\n", val);
@@ -45,6 +46,58 @@ void list_insert(list *l, int val) {
     return;
 }
 
+/* Build the list from ascending keys in one pass; duplicates are skipped.
+ * Returns the number of keys loaded, -1 if the list is not empty. */
+int list_bulk_load(list *l, const int *sorted_keys, int n) {
+    omp_on(l->lock);
+
+    if (l->head->next != NULL) {
+        omp_off(l->lock);
+        return -1;
+    }
+    node *pred = l->head;
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && sorted_keys[i] == sorted_keys[i - 1])
+            continue;
+        pred->next = node_new(sorted_keys[i]);
+        pred = pred->next;
+        l->size += 1;
+    }
+    int res = (int) l->size;
+
+    omp_off(l->lock);
+    return res;
+}
+
+
+/* Merge ascending keys into the list in one traversal, resuming from the
+ * predecessor of the previous key. Returns the number of keys inserted. */
+int list_insert_sorted_batch(list *l, const int *sorted_keys, int n) {
+    omp_on(l->lock);
+
+    int inserted = 0;
+    node *pred = l->head;
+    node *curr = l->head->next;
+    for (int i = 0; i < n; i++) {
+        int val = sorted_keys[i];
+        while (curr != NULL && curr->val < val) {
+            pred = curr;
+            curr = curr->next;
+        }
+        if (curr == NULL || curr->val != val) {
+            node *new_node = node_new(val);
+            pred->next = new_node;
+            new_node->next = curr;
+            curr = new_node;
+            l->size += 1;
+            inserted++;
+        }
+    }
+
+    omp_off(l->lock);
+    return inserted;
+}
+
 int list_delete(list *l, int val) {
     omp_on(l->lock);
 
@@ -58,7 +111,7 @@ int list_delete(list *l, int val) {
     if (curr != NULL && curr->val == val) {
         pred->next = curr->next;
         res = curr->val;
-        free(curr);
+        pool_free(curr, sizeof(node));
         l->size -= 1;
     }
 
@@ -86,14 +139,15 @@ int list_find(list *l, int val) {
 
 /* debuggin API */
 void list_print(list *l, int num_ops) {
-    char *msg = (char*) calloc(num_ops * 5, sizeof(char));
-    sprintf(msg, "[");
+    omp_on(l->lock);
+
+    printf("-> [");
     node *curr = l->head->next;
     while (curr != NULL) {
-        char buffer[5];
-        sprintf(buffer, "%d,", curr->val);
-        strcat(msg, buffer);
+        printf("%d,", curr->val);
         curr = curr->next;
     }
-    printf("-> %s]\n", msg);
+    printf("]\n");
+
+    omp_off(l->lock);
 }
@@ -5,10 +5,7 @@
 #include <stdlib.h>
 #include <omp.h>
 
-#define omp_on(lock) (omp_set_lock(&lock))
-#define omp_off(lock) (omp_unset_lock(&lock))
-#define omp_init(lock) (omp_init_lock(&lock))
-#define omp_destroy(lock) (omp_destroy_lock(&lock))
+#include "lock.h"
 
 typedef struct node node;
 typedef struct list list;
@@ -22,7 +19,7 @@ struct node {
 typedef struct list {
     node *head;        /* sentinel */
     size_t size;       /* current size */
-    omp_lock_t lock;   /* lock */
+    lock_t lock;       /* lock, see lock.h */
 } queue;
 
 
@@ -31,6 +28,8 @@ list* list_new(list *l);
 void list_insert(list *l, int val);
 int list_delete(list *l, int val);
 int list_find(list *l, int val);
+int list_bulk_load(list *l, const int *sorted_keys, int n);
+int list_insert_sorted_batch(list *l, const int *sorted_keys, int n);
 size_t list_size(list *l);
 void list_print(list *l, int num_ops);
 
@@ -1,4 +1,6 @@
 #include "l_list.h"
+#include "affinity.h"
+#include "pool.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,17 +9,58 @@
 #include <omp.h>
 #include <getopt.h>
 
+static int compare_keys(const void *a, const void *b) {
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+
+/* n random keys in ascending order */
+static int* sorted_keys(int n) {
+    int *keys = (int*) malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = rand();
+    }
+    qsort(keys, n, sizeof(int), compare_keys);
+    return keys;
+}
+
 
 int main(int argc, char** argv) {
+    affinity_policy policy = AFFINITY_NONE;
+    int numa_node = 0;
+    int preload = 0, merge = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:l:m:")) != -1) {
+        switch (opt) {
+        case 'a':
+            if (affinity_parse(optarg, &policy, &numa_node) != 0) {
+                printf("unknown affinity policy: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'l':
+            preload = strtol(optarg, NULL, 10);
+            break;
+        case 'm':
+            merge = strtol(optarg, NULL, 10);
+            break;
+        default:
+            printf("usage: %s [-a none|compact|scatter|node[:N]] [-l preload] [-m merge] threads ops insert_ratio delete_ratio\n", argv[0]);
+            exit(1);
+        }
+    }
+
     if ((argc - optind) < 4) {
         printf("I need four fixed arguments!");
         exit(1);
     }
 
-    int num_threads = strtol(argv[1], NULL, 10);
-    int num_ops = strtol(argv[2], NULL, 10);
-    float insert_ratio = strtof(argv[3], NULL);
-    float delete_ratio = strtof(argv[4], NULL);
+    int num_threads = strtol(argv[optind], NULL, 10);
+    int num_ops = strtol(argv[optind + 1], NULL, 10);
+    float insert_ratio = strtof(argv[optind + 2], NULL);
+    float delete_ratio = strtof(argv[optind + 3], NULL);
 
     /* mapping from the ratio to range(0, 1) */
     float insert_ts = insert_ratio;
@@ -29,7 +72,29 @@ int main(int argc, char** argv) {
     list l;
     list_new(&l);
 
-    # pragma omp parallel for num_threads(num_threads)
+    /* initial construction and a periodic rebuild-style merge */
+    if (preload > 0) {
+        int *keys = sorted_keys(preload);
+        double start = omp_get_wtime();
+        int loaded = list_bulk_load(&l, keys, preload);
+        printf("bulk load: %d keys in %f seconds\n", loaded, omp_get_wtime() - start);
+        free(keys);
+    }
+    if (merge > 0) {
+        int *keys = sorted_keys(merge);
+        double start = omp_get_wtime();
+        int inserted = list_insert_sorted_batch(&l, keys, merge);
+        printf("sorted batch: %d of %d keys in %f seconds\n", inserted, merge, omp_get_wtime() - start);
+        free(keys);
+    }
+
+    # pragma omp parallel num_threads(num_threads)
+    {
+    /* pin first, then pre-touch this thread's nodes on its own NUMA node */
+    affinity_pin(policy, numa_node, omp_get_thread_num());
+    pool_reserve(sizeof(node), num_ops / num_threads + 1);
+
+    # pragma omp for
     for (int i = 0; i < num_ops; i++) {
         float r = (float) rand() / (float) RAND_MAX;
         int num  = rand();
@@ -53,6 +118,7 @@ int main(int argc, char** argv) {
             #endif
         }
     }
+    }
 
     #ifdef DEBUG
     list_print(&l, num_ops);
@@ -1,8 +1,9 @@
 #include "l_queue.h"
+#include "pool.h"
 #include <string.h>
 
 node* node_new(int val) {
-    node *new_node = (node*) malloc(sizeof(node));
+    node *new_node = (node*) pool_alloc(sizeof(node));
     if (new_node == NULL) {
 #ifdef DEBUG
         printf("node_new(%d) failed\n", val);
@@ -101,7 +102,7 @@ int queue_pop(queue *q) {
     }
 
     int res = curr->val;
-    free(curr); /* free obsolete node */
+    pool_free(curr, sizeof(node)); /* free obsolete node */
 
     omp_off(q->lock);
     return res;
@@ -5,10 +5,7 @@
 #include <stdlib.h>
 #include <omp.h>
 
-#define omp_on(lock) (omp_set_lock(&lock))
-#define omp_off(lock) (omp_unset_lock(&lock))
-#define omp_init(lock) (omp_init_lock(&lock))
-#define omp_destroy(lock) (omp_destroy_lock(&lock))
+#include "lock.h"
 
 typedef struct node node;
 
@@ -22,7 +19,7 @@ typedef struct queue {
     node *head;        /* sentinel */
     node *tail;        /* latest data */
     size_t size;       /* current size */
-    omp_lock_t lock;   /* lock */
+    lock_t lock;       /* lock, see lock.h */
 } queue;
 
 
@@ -1,4 +1,7 @@
 #include "l_queue.h"
+#include "affinity.h"
+#include "pool.h"
+#include "bench.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,24 +9,116 @@
 #include <unistd.h>
 #include <omp.h>
 #include <getopt.h>
+#include <sched.h>
+
+/* P producers and C consumers on dedicated threads pass num_ops items,
+ * each stamped with its (scheduled, under an offered rate) send time.
+ * The int payload is the item's index into sent[], which holds the full
+ * 64-bit stamps, so long backlogs do not wrap the latencies. */
+static void run_topology(queue *q, int producers, int consumers, int num_ops,
+                         double rate, affinity_policy policy, int numa_node) {
+    long *lat = (long*) malloc(num_ops * sizeof(long));
+    long *sent = (long*) malloc(num_ops * sizeof(long));
+    long received = 0;
+    long start = bench_now_ns();
+
+    # pragma omp parallel num_threads(producers + consumers)
+    {
+    int tid = omp_get_thread_num();
+    affinity_pin(policy, numa_node, tid);
+
+    if (tid < producers) {
+        pool_reserve(sizeof(node), num_ops / producers + 1);
+        long k = 0;
+        for (long i = tid; i < num_ops; i += producers, k++) {
+            long stamp = bench_schedule(start, rate, producers, tid, k);
+            if (stamp < 0) {
+                stamp = bench_now_ns();
+            } else {
+                bench_wait_until(stamp);
+            }
+            sent[i] = stamp;
+            queue_push(q, (int) i);
+        }
+    } else {
+        while (__atomic_load_n(&received, __ATOMIC_RELAXED) < num_ops) {
+            int i = queue_pop(q);
+            if (i == -1) {
+                sched_yield();
+                continue;
+            }
+            lat[__sync_fetch_and_add(&received, 1)] = bench_now_ns() - sent[i];
+        }
+    }
+    }
+
+    bench_report(producers, consumers, rate, lat, num_ops, bench_now_ns() - start);
+    free(sent);
+    free(lat);
+}
 
 
 int main(int argc, char** argv) {
+    affinity_policy policy = AFFINITY_NONE;
+    int numa_node = 0;
+    int producers = 0, consumers = 0;
+    double rate = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:P:C:R:")) != -1) {
+        switch (opt) {
+        case 'a':
+            if (affinity_parse(optarg, &policy, &numa_node) != 0) {
+                printf("unknown affinity policy: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'P':
+            producers = strtol(optarg, NULL, 10);
+            break;
+        case 'C':
+            consumers = strtol(optarg, NULL, 10);
+            break;
+        case 'R':
+            rate = strtod(optarg, NULL);
+            break;
+        default:
+            printf("usage: %s [-a none|compact|scatter|node[:N]] [-P producers] [-C consumers] [-R ops_per_sec] threads ops push_ratio\n", argv[0]);
+            exit(1);
+        }
+    }
+
     if ((argc - optind) < 3) {
         printf("I need three fixed arguments!");
         exit(1);
     }
 
-    int num_threads = strtol(argv[1], NULL, 10);
-    int num_ops = strtol(argv[2], NULL, 10);
-    float push_ratio = strtof(argv[3], NULL);
+    int num_threads = strtol(argv[optind], NULL, 10);
+    int num_ops = strtol(argv[optind + 1], NULL, 10);
+    float push_ratio = strtof(argv[optind + 2], NULL);
 
     time_t t;
     srand((unsigned) time(&t));
 
     queue *q = queue_new();
 
-    # pragma omp parallel for num_threads(num_threads)
+    /* dedicated producers and consumers, push_ratio is ignored */
+    if (producers > 0 || consumers > 0) {
+        if (consumers < 1)
+            consumers = 1;
+        if (producers < 1)
+            producers = (num_threads > consumers) ? num_threads - consumers : 1;
+        run_topology(q, producers, consumers, num_ops, rate, policy, numa_node);
+        queue_delete(q);
+        return 0;
+    }
+
+    # pragma omp parallel num_threads(num_threads)
+    {
+    /* pin first, then pre-touch this thread's nodes on its own NUMA node */
+    affinity_pin(policy, numa_node, omp_get_thread_num());
+    pool_reserve(sizeof(node), num_ops / num_threads + 1);
+
+    # pragma omp for
     for (int i = 0; i < num_ops; i++) {
         #ifdef DEBUG
         printf("current idx: %d\n", i);
@@ -45,6 +140,7 @@ int main(int argc, char** argv) {
             #endif
         }
     }
+    }
 
     #ifdef DEBUG
     queue_print(q, num_ops);
@@ -1,6 +1,7 @@
 #include "lf_list.h"
+#include "pool.h"
 #include "limits.h"
-#include "string.h"
+#include <sched.h>
 
 int is_marked(long i) {
     return (int) (i & 0x1L);
@@ -15,64 +16,230 @@ long get_marked(const long w) {
 }
 
 
+/* CAS of n->next, bracketed for list_range */
+static int next_cas(node *n, node *old_val, node *new_val) {
+    ANF(&n->begin);
+    int done = CAS(&(n->next), old_val, new_val);
+    ANF(&n->end);
+    return done;
+}
+
+
 list* list_new(list *l) {
-    node* head = (node*) malloc(sizeof(node));
+    node* head = (node*) pool_alloc(sizeof(node));
     head->next = NULL;
     head->val = INT_MIN;
+    head->begin = head->end = 0;
 
-    node* tail = (node*) malloc(sizeof(node));
+    node* tail = (node*) pool_alloc(sizeof(node));
     tail->next = NULL;
     tail->val = INT_MAX;
+    tail->begin = tail->end = 0;
 
     l->head = head;
     l->head->next = tail;
     l->tail = tail;
+    l->released = 0;
     return l;
 }
 
 
+void finger_init(list *l, finger *f) {
+    f->pos = l->head;
+    f->released = __atomic_load_n(&l->released, __ATOMIC_SEQ_CST);
+}
+
+
+/* start of a search: the finger when there is one and no node may have
+ * been relinked since it was taken, the head otherwise */
+static node* finger_start(list *l, finger *f) {
+    if (f == NULL) {
+        return l->head;
+    }
+    long released = __atomic_load_n(&l->released, __ATOMIC_SEQ_CST);
+    if (released != f->released) {
+        f->pos = l->head;
+        f->released = released;
+    }
+    return f->pos;
+}
+
+
+static void finger_move(finger *f, node *left_node) {
+    if (f != NULL) {
+        f->pos = left_node;
+    }
+}
+
+
 int list_insert(list *l, int val) {
+    return list_insert_finger(l, NULL, val);
+}
+
+
+int list_delete(list *l, int val) {
+    return list_delete_finger(l, NULL, val);
+}
+
+
+int list_find(list *l, int val) {
+    return list_find_finger(l, NULL, val);
+}
+
+
+/* Link new_node (its val set) unless the key is present; 1 if linked. */
+static int insert_node(list *l, finger *f, node *new_node) {
     node *right_node, *left_node;
     right_node = left_node = NULL;
-    node *new_node = (node*) malloc(sizeof(node));
-    new_node->next = NULL;
-    new_node->val = val;
+    int val = new_node->val;
+    new_node->begin = new_node->end = 0;
     while(1) {
-        right_node = list_search(l, val, &left_node);
+        right_node = list_search_from(l, finger_start(l, f), val, &left_node);
+        finger_move(f, left_node);
         if ((right_node != l->tail) && (right_node->val == val)) {
             return 0;
         }
         new_node->next = right_node;
-        if (CAS(&(left_node->next), right_node, new_node)) {
+        if (next_cas(left_node, right_node, new_node)) {
             return 1; }
     }
 }
 
 
-int list_delete(list *l, int val) {
+int list_insert_finger(list *l, finger *f, int val) {
+    node *new_node = (node*) pool_alloc(sizeof(node));
+    new_node->next = NULL;
+    new_node->val = val;
+    if (!insert_node(l, f, new_node)) {
+        pool_free(new_node, sizeof(node));
+        return 0;
+    }
+    return 1;
+}
+
+
+/* Mark and unlink the node holding val; NULL if there is none. */
+static node* delete_node(list *l, finger *f, int val) {
     node *right_node, *right_node_next, *left_node;
     right_node = right_node_next = left_node = NULL;
     while (1) {
-        right_node = list_search(l, val, &left_node);
+        right_node = list_search_from(l, finger_start(l, f), val, &left_node);
+        finger_move(f, left_node);
         if ((right_node == l->tail) || (right_node->val != val)) {
-            return -1;
+            return NULL;
         }
         right_node_next = right_node->next;
-        if (!is_marked((long) right_node_next))
-            if (CAS(&(right_node->next), right_node_next,
-                get_marked((long) right_node_next)))
+        if (!is_marked((long) right_node_next)) {
+            if (next_cas(right_node, right_node_next,
+                (node*) get_marked((long) right_node_next)))
                 break;
+        }
     }
-    if (!CAS(&(left_node->next), right_node, right_node_next)) {
-        right_node = list_search(l, right_node->val, &left_node);
+    node *deleted = right_node;
+    if (!next_cas(left_node, right_node, right_node_next)) {
+        right_node = list_search_from(l, finger_start(l, f), right_node->val, &left_node);
+        finger_move(f, left_node);
     }
-    return val;
+    return deleted;
 }
 
 
-int list_find(list *l, int val) {
+int list_delete_finger(list *l, finger *f, int val) {
+    return (delete_node(l, f, val) != NULL) ? val : -1;
+}
+
+
+/* Intrusive variants: the caller owns the node, typically embedded in
+ * its own struct (see container_of), and nothing is allocated or freed.
+ * list_insert_node links n with key n->val and returns 1, or returns 0
+ * and leaves n untouched if the key is present. list_delete_node returns
+ * the node it removed, or NULL. Concurrent searches may still be
+ * traversing a removed node, so it may only be linked into a container
+ * again once every operation that overlapped the delete has returned.
+ * Fingers of l that may point at it start their next search from the
+ * head (see finger_start), so relinking it elsewhere is safe for them. */
+int list_insert_node(list *l, node *n) {
+    return insert_node(l, NULL, n);
+}
+
+
+node* list_delete_node(list *l, int val) {
+    node *n = delete_node(l, NULL, val);
+    if (n != NULL) {
+        /* before the caller can relink n: fingers that may point at it reset */
+        __atomic_add_fetch(&l->released, 1, __ATOMIC_SEQ_CST);
+    }
+    return n;
+}
+
+
+/* Build the list from ascending keys in one pass; duplicates are skipped.
+ * The list must be empty: the chain is linked privately and published with
+ * a single CAS. Returns the number of keys loaded, -1 if the list is not
+ * empty. */
+int list_bulk_load(list *l, const int *sorted_keys, int n) {
+    node *first = l->tail;
+    node **link = &first;
+    int loaded = 0;
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && sorted_keys[i] == sorted_keys[i - 1])
+            continue;
+        node *new_node = (node*) pool_alloc(sizeof(node));
+        new_node->val = sorted_keys[i];
+        new_node->begin = new_node->end = 0;
+        *link = new_node;
+        link = &new_node->next;
+        loaded++;
+    }
+    *link = l->tail;
+
+    if (!next_cas(l->head, l->tail, first)) {
+        while (first != l->tail) {
+            node *next = first->next;
+            pool_free(first, sizeof(node));
+            first = next;
+        }
+        return -1;
+    }
+    return loaded;
+}
+
+
+/* Insert ascending keys in one traversal: each search resumes from the
+ * node found for the previous key instead of the head. Returns the number
+ * of keys inserted. */
+int list_insert_sorted_batch(list *l, const int *sorted_keys, int n) {
     node *right_node, *left_node;
-    right_node = list_search(l, val, &left_node);
+    node *start = l->head;
+    int inserted = 0;
+    for (int i = 0; i < n; i++) {
+        int val = sorted_keys[i];
+        node *new_node = (node*) pool_alloc(sizeof(node));
+        new_node->val = val;
+        new_node->begin = new_node->end = 0;
+        while (1) {
+            right_node = list_search_from(l, start, val, &left_node);
+            if ((right_node != l->tail) && (right_node->val == val)) {
+                pool_free(new_node, sizeof(node));
+                start = right_node;
+                break;
+            }
+            new_node->next = right_node;
+            if (next_cas(left_node, right_node, new_node)) {
+                start = new_node;
+                inserted++;
+                break;
+            }
+        }
+    }
+    return inserted;
+}
+
+
+int list_find_finger(list *l, finger *f, int val) {
+    node *right_node, *left_node;
+    right_node = list_search_from(l, finger_start(l, f), val, &left_node);
+    finger_move(f, left_node);
     if ((right_node == l->tail) || (right_node->val != val)) {
         return 0;
     } else {
@@ -82,11 +249,22 @@ int list_find(list *l, int val) {
 
 
 node* list_search(list *l, int val, node **left_node) {
+    return list_search_from(l, l->head, val, left_node);
+}
+
+
+/* list_search starting at start instead of the head. start is only used
+ * while it is unmarked and smaller than val, otherwise we go from the head. */
+node* list_search_from(list *l, node *start, int val, node **left_node) {
     node *left_node_next, *right_node;
     left_node_next = right_node = NULL;
     while(1) {
-        node *t = l->head;
-        node *t_next = l->head->next;
+        node *t = start;
+        node *t_next = start->next;
+        if (t != l->head && (is_marked((long) t_next) || t->val >= val)) {
+            t = l->head;
+            t_next = l->head->next;
+        }
         /* Find left_node and right_node */
         while (is_marked((long) t_next) || (t->val < val)) {
             if (!is_marked((long) t_next)) { // valid
@@ -106,7 +284,7 @@ node* list_search(list *l, int val, node **left_node) {
         }
 
         /* Remove one or more marked nodes */
-        if (CAS(&((*left_node)->next), left_node_next, right_node)) {
+        if (next_cas(*left_node, left_node_next, right_node)) {
             if ((right_node == l->tail) && !is_marked((long) right_node->next))
                 return right_node;
         }
@@ -114,16 +292,113 @@ node* list_search(list *l, int val, node **left_node) {
 }
 
 
+/* The last unmarked node with a key below lo, or the head. */
+static node* range_left(list *l, int lo) {
+    node *left = l->head;
+    node *t = l->head;
+    while (t != l->tail && (t == l->head || t->val < lo)) {
+        node *t_next = __atomic_load_n(&t->next, __ATOMIC_ACQUIRE);
+        if (!is_marked((long) t_next))
+            left = t;
+        t = (node*) get_unmarked((long) t_next);
+    }
+    return left;
+}
+
+
+/* A node of a scan, its next word and how many updates of it had begun. */
+typedef struct {
+    node *n;
+    long next;
+    long begin;
+} range_entry;
+
+
+/* Collect left and every node after it up to the last key <= hi into
+ * *entries and return their number, or -1 if one of them had an update of
+ * its next word in flight. */
+static int range_collect(list *l, node *left, int hi, range_entry **entries, int *cap) {
+    int n = 0;
+    node *t = left;
+    while (1) {
+        long end = __atomic_load_n(&t->end, __ATOMIC_ACQUIRE);
+        long begin = __atomic_load_n(&t->begin, __ATOMIC_ACQUIRE);
+        if (begin != end)
+            return -1;
+        long w = (long) __atomic_load_n(&t->next, __ATOMIC_ACQUIRE);
+        if (n == *cap) {
+            *cap *= 2;
+            *entries = (range_entry*) realloc(*entries, *cap * sizeof(range_entry));
+        }
+        (*entries)[n].n = t;
+        (*entries)[n].next = w;
+        (*entries)[n].begin = begin;
+        n++;
+        t = (node*) get_unmarked(w);
+        if (t == l->tail || t->val > hi)
+            return n;
+    }
+}
+
+
+/* 1 if no update of a collected next word has begun since it was read. */
+static int range_validate(range_entry *entries, int n) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (int i = 0; i < n; i++) {
+        if (__atomic_load_n(&entries[i].n->begin, __ATOMIC_ACQUIRE) != entries[i].begin)
+            return 0;
+    }
+    return 1;
+}
+
+
+/* Call cb on every key in [lo, hi] in ascending order and return their count.
+ * The scan collects the next words from the last unmarked node before lo to
+ * the end of the range. For each node it first checks that the end and begin
+ * counts match, so no CAS of its next word was in flight, and then it reads
+ * the word. Afterwards it checks that no node's begin count has moved. The
+ * counts only grow, so a word that changed and changed back still fails the
+ * check. Every word therefore held its value from the first count check to
+ * the final one, and these intervals overlap. The first node was unmarked,
+ * so it was reachable then, and the keys are the exact content of the range
+ * at that point. Updates inside the range (or to the node before it) make
+ * the scan retry, and updaters never wait for it. Intrusive nodes must not
+ * be relinked while a scan that may reach them runs, since relinking resets
+ * their counts. */
+int list_range(list *l, int lo, int hi, range_cb cb, void *arg) {
+    int cap = 64, n;
+    range_entry *entries = (range_entry*) malloc(cap * sizeof(range_entry));
+
+    while (1) {
+        node *left = range_left(l, lo);
+        n = range_collect(l, left, hi, &entries, &cap);
+        if (n > 0 && !is_marked(entries[0].next) && range_validate(entries, n)) {
+            break;
+        }
+        sched_yield();
+    }
+
+    int num = 0;
+    for (int i = 1; i < n; i++) {
+        node *t = entries[i].n;
+        if (!is_marked(entries[i].next) && t->val >= lo) {
+            cb(t->val, arg);
+            num++;
+        }
+    }
+    free(entries);
+    return num;
+}
+
+
 /* debuggin API */
+static void print_key(int val, void *arg) {
+    printf("%d,", val);
+}
+
+
 void list_print(list *l, int num_ops) {
-    char *msg = (char*) calloc(num_ops * 5, sizeof(char));
-    sprintf(msg, "[");
-    node *curr = l->head->next;
-    while (curr != NULL && curr->val != INT_MAX) {
-        char buffer[5];
-        sprintf(buffer, "%d,", curr->val);
-        strcat(msg, buffer);
-        curr = curr->next;
-    }
-    printf("-> %s]\n", msg);
+    printf("-> [");
+    list_range(l, INT_MIN, INT_MAX, print_key, NULL);
+    printf("]\n");
 }
@@ -3,21 +3,46 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #define CAS(ptr,old_val,new_val) \
     (__sync_bool_compare_and_swap(ptr, old_val, new_val))
+#define ANF(ptr) (__sync_add_and_fetch(ptr, 1))
+
+/* the struct embedding member at ptr */
+#ifndef container_of
+#define container_of(ptr,type,member) \
+    ((type*) ((char*) (ptr) - offsetof(type, member)))
+#endif
 
 typedef struct node node;
 typedef struct list list;
+typedef struct finger finger;
+typedef void (*range_cb)(int val, void *arg);
 
+/* Every CAS of next is bracketed by begin/end increments, so list_range
+ * can tell whether next may have changed while it was reading it. */
 struct node {
     int val;
     node *next;
+    long begin;
+    long end;
 };
 
 struct list {
     node *head;
     node *tail;
+    long released;     /* nodes handed back by list_delete_node */
+};
+
+/* Per-thread search hint: the left node where the thread's last operation
+ * stopped. Nodes are never freed, so a stale finger is always safe to read;
+ * list_search_from ignores it once it is marked or past the key. A node
+ * handed back by list_delete_node may be relinked into another list, so
+ * a finger taken before l->released last changed starts from the head. */
+struct finger {
+    node *pos;
+    long released;
 };
 
 int is_marked(const long i);
@@ -30,7 +55,17 @@ list* list_new(list *l);
 int list_insert(list *l, int val);
 int list_delete(list *l, int val);
 int list_find(list *l, int val);
+void finger_init(list *l, finger *f);
+int list_insert_finger(list *l, finger *f, int val);
+int list_delete_finger(list *l, finger *f, int val);
+int list_find_finger(list *l, finger *f, int val);
+int list_insert_node(list *l, node *n);
+node* list_delete_node(list *l, int val);
+int list_bulk_load(list *l, const int *sorted_keys, int n);
+int list_insert_sorted_batch(list *l, const int *sorted_keys, int n);
 node* list_search(list *l, int val, node **left_node);
+node* list_search_from(list *l, node *start, int val, node **left_node);
+int list_range(list *l, int lo, int hi, range_cb cb, void *arg);
 void list_print(list *l, int num_ops);
 
 #endif //MULTICORE_LF_LIST_H
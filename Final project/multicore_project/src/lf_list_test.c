@@ -1,27 +1,101 @@
 #include "lf_list.h"
+#include "affinity.h"
+#include "pool.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <time.h>
 #include <unistd.h>
 #include <omp.h>
 #include <getopt.h>
 
+/* width of the key interval scanned by a range query */
+#define RANGE_WIDTH (RAND_MAX / 1000)
+
+/* a caller-owned object for the intrusive list */
+typedef struct item {
+    long payload;
+    node link;
+} item;
+
+
+static int compare_keys(const void *a, const void *b) {
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+
+/* n random keys in ascending order */
+static int* sorted_keys(int n) {
+    int *keys = (int*) malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = rand();
+    }
+    qsort(keys, n, sizeof(int), compare_keys);
+    return keys;
+}
+
+static void count_key(int val, void *arg) {
+    (*(long*) arg)++;
+}
+
 
 int main(int argc, char** argv) {
+    affinity_policy policy = AFFINITY_NONE;
+    int numa_node = 0;
+    int preload = 0, merge = 0;
+    float range_ratio = 0;
+    int use_finger = 0, stride = 0;
+    int intrusive = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:r:l:m:fs:i")) != -1) {
+        switch (opt) {
+        case 'a':
+            if (affinity_parse(optarg, &policy, &numa_node) != 0) {
+                printf("unknown affinity policy: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'r':
+            range_ratio = strtof(optarg, NULL);
+            break;
+        case 'l':
+            preload = strtol(optarg, NULL, 10);
+            break;
+        case 'm':
+            merge = strtol(optarg, NULL, 10);
+            break;
+        case 'f':
+            use_finger = 1;
+            break;
+        case 's':
+            stride = strtol(optarg, NULL, 10);
+            break;
+        case 'i':
+            intrusive = 1;
+            break;
+        default:
+            printf("usage: %s [-a none|compact|scatter|node[:N]] [-r range_ratio] [-l preload] [-m merge] [-f] [-s stride] [-i] threads ops insert_ratio delete_ratio\n", argv[0]);
+            exit(1);
+        }
+    }
+
     if ((argc - optind) < 4) {
         printf("I need four fixed arguments!");
         exit(1);
     }
 
-    int num_threads = strtol(argv[1], NULL, 10);
-    int num_ops = strtol(argv[2], NULL, 10);
-    float insert_ratio = strtof(argv[3], NULL);
-    float delete_ratio = strtof(argv[4], NULL);
+    int num_threads = strtol(argv[optind], NULL, 10);
+    int num_ops = strtol(argv[optind + 1], NULL, 10);
+    float insert_ratio = strtof(argv[optind + 2], NULL);
+    float delete_ratio = strtof(argv[optind + 3], NULL);
 
     /* mapping from the ratio to range(0, 1) */
     float insert_ts = insert_ratio;
     float delete_ts = insert_ts + delete_ratio;
+    float range_ts = delete_ts + range_ratio;
 
     time_t t;
     srand((unsigned) time(&t));
@@ -29,33 +103,92 @@ int main(int argc, char** argv) {
     list l;
     list_new(&l);
 
-    # pragma omp parallel for num_threads(num_threads)
+    /* initial construction and a periodic rebuild-style merge */
+    if (preload > 0) {
+        int *keys = sorted_keys(preload);
+        double start = omp_get_wtime();
+        int loaded = list_bulk_load(&l, keys, preload);
+        printf("bulk load: %d keys in %f seconds\n", loaded, omp_get_wtime() - start);
+        free(keys);
+    }
+    if (merge > 0) {
+        int *keys = sorted_keys(merge);
+        double start = omp_get_wtime();
+        int inserted = list_insert_sorted_batch(&l, keys, merge);
+        printf("sorted batch: %d of %d keys in %f seconds\n", inserted, merge, omp_get_wtime() - start);
+        free(keys);
+    }
+
+    /* -i: one preallocated item per operation, linked by its embedded node */
+    item *items = intrusive ? (item*) malloc(num_ops * sizeof(item)) : NULL;
+    long checksum = 0;
+
+    # pragma omp parallel num_threads(num_threads) reduction(+:checksum)
+    {
+    /* pin first, then pre-touch this thread's nodes on its own NUMA node */
+    affinity_pin(policy, numa_node, omp_get_thread_num());
+    pool_reserve(sizeof(node), num_ops / num_threads + 1);
+
+    /* this thread's search hint and, with a stride, its walk over the keys */
+    finger f;
+    finger_init(&l, &f);
+    finger *fp = use_finger ? &f : NULL;
+    int prev = rand();
+
+    # pragma omp for
     for (int i = 0; i < num_ops; i++) {
         float r = (float) rand() / (float) RAND_MAX;
         int num  = rand();
-        if (r < insert_ts)  {
-            list_insert(&l, num);
+        if (stride > 0) {
+            num = (prev > RAND_MAX - stride) ? num % stride : prev + 1 + num % stride;
+            prev = num;
+        }
+        if (r < insert_ts && intrusive)  {
+            items[i].payload = i;
+            items[i].link.val = num;
+            list_insert_node(&l, &items[i].link);
+        } else if (insert_ts < r && r < delete_ts && intrusive) {
+            node *n = list_delete_node(&l, num);
+            if (n != NULL)
+                checksum += container_of(n, item, link)->payload;
+
+            #ifdef DEBUG
+            printf("deleting %d, index: %d, found: %d, by %d\n", num, i, n != NULL, (int) omp_get_thread_num());
+            #endif
+        } else if (r < insert_ts)  {
+            list_insert_finger(&l, fp, num);
 
             #ifdef DEBUG
             printf("inserting %d, index: %d, by %d\n", num, i, omp_get_thread_num());
             #endif
         } else if (insert_ts < r && r < delete_ts) {
-            int val = list_delete(&l, num);
+            int val = list_delete_finger(&l, fp, num);
 
             #ifdef DEBUG
             printf("deleting %d, index: %d, status: %d, by %d\n", num, i, val, (int) omp_get_thread_num());
             #endif
+        } else if (delete_ts < r && r < range_ts) {
+            long found = 0;
+            int hi = (num > INT_MAX - RANGE_WIDTH) ? INT_MAX : num + RANGE_WIDTH;
+            list_range(&l, num, hi, count_key, &found);
+
+            #ifdef DEBUG
+            printf("scanning [%d, %d], index: %d, found: %ld, by %d\n", num, hi, i, found, (int) omp_get_thread_num());
+            #endif
         } else {
-            int val = list_find(&l, num);
+            int val = list_find_finger(&l, fp, num);
 
             #ifdef DEBUG
             printf("finding %d, index: %d, status: %d, by %d\n", num, i, val, (int) omp_get_thread_num());
             #endif
         }
     }
+    }
 
     #ifdef DEBUG
     list_print(&l, num_ops);
+    if (intrusive)
+        printf("checksum of deleted payloads: %ld\n", checksum);
     #endif
 
     return 0;
@@ -1,15 +1,20 @@
 #include "lf_queue.h"
+#include "pool.h"
 #include <stdio.h> 
 #include <stdlib.h> 
 #include <string.h>
 #include <errno.h>
 
+#define LOAD(ptr) (__atomic_load_n(ptr, __ATOMIC_ACQUIRE))
+#define STORE(ptr,val) (__atomic_store_n(ptr, val, __ATOMIC_RELEASE))
+
 int queue_new(queue *q) {
     // sentinel
-    node *new_node = calloc(1, sizeof(node));
+    node *new_node = pool_alloc(sizeof(node));
     if (!new_node)  {
         return -errno;
     }
+    memset(new_node, 0, sizeof(node));
 
     memset(q, 0, sizeof(queue));
     q->head = q->tail = new_node;
@@ -18,7 +23,56 @@ int queue_new(queue *q) {
 }
 
 
+/* capacity is rounded up to a power of two; it only bounds SPSC queues */
+int queue_new_kind(queue *q, queue_kind kind, int capacity) {
+    if (kind != QUEUE_SPSC) {
+        int res = queue_new(q);
+        q->kind = kind;
+        return res;
+    }
+
+    unsigned long size = 1;
+    while (size < (unsigned long) capacity)
+        size <<= 1;
+
+    memset(q, 0, sizeof(queue));
+    q->kind = QUEUE_SPSC;
+    q->ring = (ring*) aligned_alloc(64, sizeof(ring));
+    if (!q->ring) {
+        return -errno;
+    }
+    memset(q->ring, 0, sizeof(ring));
+    q->ring->slots = (void**) malloc(size * sizeof(void*));
+    if (!q->ring->slots) {
+        free(q->ring);
+        q->ring = NULL;
+        return -errno;
+    }
+    q->ring->mask = size - 1;
+    return 0;
+}
+
+
+int queue_parse_kind(const char *name, queue_kind *kind) {
+    if (strcmp(name, "mpmc") == 0) {
+        *kind = QUEUE_MPMC;
+    } else if (strcmp(name, "mpsc") == 0) {
+        *kind = QUEUE_MPSC;
+    } else if (strcmp(name, "spsc") == 0) {
+        *kind = QUEUE_SPSC;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
 int queue_delete(queue *q){
+    if (q->ring) {
+        free(q->ring->slots);
+        free(q->ring);
+        memset(q, 0, sizeof(queue));
+    }
     if (q->tail && q->head) {
         node *curr = q->head;
         node *tmp;
@@ -26,11 +80,11 @@ int queue_delete(queue *q){
         // iterate through nodes
         while (curr != q->tail) {
             tmp = curr->next;
-            free(curr);
+            pool_free(curr, sizeof(node));
             curr = tmp;
         }
 
-        free(q->head);
+        pool_free(q->tail, sizeof(node));
         memset(q, 0, sizeof(queue));
     }
 
@@ -38,14 +92,72 @@ int queue_delete(queue *q){
 }
 
 
+/* -EAGAIN when the ring is full */
+static int spsc_push(ring *r, void *val) {
+    unsigned long tail = r->tail;
+    if (tail - r->cached_head > r->mask) {
+        r->cached_head = LOAD(&r->head);
+        if (tail - r->cached_head > r->mask)
+            return -EAGAIN;
+    }
+    r->slots[tail & r->mask] = val;
+    STORE(&r->tail, tail + 1);
+    return 0;
+}
+
+
+static void* spsc_pop(ring *r) {
+    unsigned long head = r->head;
+    if (head == r->cached_tail) {
+        r->cached_tail = LOAD(&r->tail);
+        if (head == r->cached_tail)
+            return 0;
+    }
+    void *val = r->slots[head & r->mask];
+    STORE(&r->head, head + 1);
+    return val;
+}
+
+
+/* The swap orders the producers; the consumer may briefly see the old
+ * tail without its next link, which reads as empty. */
+static int mpsc_push(queue *q, node *new_node) {
+    node *prev = __atomic_exchange_n(&q->tail, new_node, __ATOMIC_ACQ_REL);
+    STORE(&prev->next, new_node);
+    return 0;
+}
+
+
+static void* mpsc_pop(queue *q) {
+    node *head = q->head;
+    node *next = LOAD(&head->next);
+    if (next == 0) {
+        return 0;
+    }
+    void *val = next->val;
+    q->head = next;
+    pool_free(head, sizeof(node));
+    return val;
+}
+
+
 int queue_push(queue *q, void *val) {
+    if (q->kind == QUEUE_SPSC) {
+        return spsc_push(q->ring, val);
+    }
+
     node *tail;
-    node *new_node = calloc(1, sizeof(node));
+    node *new_node = pool_alloc(sizeof(node));
     if (!new_node) {
         return -errno;
     }
 
     new_node->val = val;
+    new_node->next = NULL;
+    if (q->kind == QUEUE_MPSC) {
+        return mpsc_push(q, new_node);
+    }
+
     do {
         tail = q->tail;
         if ( CAS(&q->tail, tail, new_node)) {
@@ -60,6 +172,12 @@ int queue_push(queue *q, void *val) {
 
 
 void* queue_pop(queue *q) {
+    if (q->kind == QUEUE_SPSC) {
+        return spsc_pop(q->ring);
+    } else if (q->kind == QUEUE_MPSC) {
+        return mpsc_pop(q);
+    }
+
     void *val = 0;
     node *head;
 
@@ -68,7 +186,7 @@ void* queue_pop(queue *q) {
      * After getting it, assign it to zero,
      * thid thread prevents other threads from getting it */
     do {
-        head = q->head;
+        head = LOAD(&q->head);
     } while (head == 0 || !CAS(&q->head, head, 0));
 
     // queue is empty
@@ -80,21 +198,67 @@ void* queue_pop(queue *q) {
     q->head = head->next;
 
     SNF(&q->count);
-    free(head);
+    pool_free(head, sizeof(node));
 
     return val;
 }
 
+void iqueue_new(iqueue *q) {
+    q->stub.next = NULL;
+    q->head = q->tail = &q->stub;
+}
+
+
+void iqueue_push(iqueue *q, qlink *link) {
+    link->next = NULL;
+    qlink *prev = __atomic_exchange_n(&q->tail, link, __ATOMIC_ACQ_REL);
+    STORE(&prev->next, link);
+}
+
+
+/* The head link stays in the queue as its sentinel, so it is only handed
+ * out once it has a successor; the stub is pushed behind the last link to
+ * release it. NULL when empty, or while the push of the only successor is
+ * still in flight. Consumers hold the head spin-lock, as in queue_pop. */
+qlink* iqueue_pop(iqueue *q) {
+    qlink *head;
+    do {
+        head = LOAD(&q->head);
+    } while (head == 0 || !CAS(&q->head, head, 0));
+
+    qlink *res = NULL;
+    qlink *next = LOAD(&head->next);
+    if (head == &q->stub && next != NULL) {
+        head = next;
+        next = LOAD(&head->next);
+    }
+    if (head != &q->stub) {
+        if (next == NULL && head == LOAD(&q->tail)) {
+            iqueue_push(q, &q->stub);
+            next = LOAD(&head->next);
+        }
+        if (next != NULL) {
+            res = head;
+            head = next;
+        }
+    }
+
+    STORE(&q->head, head);
+    return res;
+}
+
 /* debuggin API */
 void queue_print(queue *q, int num_ops) {
-    char *msg = (char*) calloc(num_ops * 5, sizeof(char));
-    sprintf(msg, "[");
-    node *curr = q->head->next;
-    while (curr != NULL) {
-        char buffer[5];
-        sprintf(buffer, "%ld,", (long) curr->val);
-        strcat(msg, buffer);
-        curr = curr->next;
-    }
-    printf("-> %s]\n", msg);
+    printf("-> [");
+    if (q->ring) {
+        ring *r = q->ring;
+        for (unsigned long i = r->head; i != r->tail; i++) {
+            printf("%ld,", (long) r->slots[i & r->mask]);
+        }
+    } else {
+        for (node *curr = q->head->next; curr != NULL; curr = curr->next) {
+            printf("%ld,", (long) curr->val);
+        }
+    }
+    printf("]\n");
 }
@@ -6,24 +6,80 @@
 #define ANF(ptr) (__sync_add_and_fetch(ptr, 1))
 #define SNF(ptr) (__sync_sub_and_fetch(ptr, 1))
 
+/* the struct embedding member at ptr */
+#ifndef container_of
+#define container_of(ptr,type,member) \
+    ((type*) ((char*) (ptr) - offsetof(type, member)))
+#endif
+
+#include <stddef.h>
+
 typedef struct node node;
+typedef struct ring ring;
 typedef struct queue queue;
+typedef struct qlink qlink;
+typedef struct iqueue iqueue;
+
+/* Chosen at construction. MPMC is the CAS-based queue below; MPSC lets
+ * producers swap the tail and the single consumer pop without a CAS;
+ * SPSC is a bounded ring without any atomic read-modify-write. Calling
+ * queue_push / queue_pop from more threads than the kind allows is
+ * undefined. */
+typedef enum {
+    QUEUE_MPMC,
+    QUEUE_MPSC,
+    QUEUE_SPSC
+} queue_kind;
 
 struct node{
     void *val;
     node *next;
 };
 
+/* Each side owns one index and caches the other side's, so it only
+ * reads the shared index when the cached one says full / empty. */
+struct ring {
+    void **slots;
+    unsigned long mask;
+    unsigned long head __attribute__((aligned(64)));   /* consumer */
+    unsigned long cached_tail;
+    unsigned long tail __attribute__((aligned(64)));   /* producer */
+    unsigned long cached_head;
+};
+
 struct queue{
     node *head;
     node *tail;
     int count;
+    queue_kind kind;
+    ring *ring;
+};
+
+/* Intrusive queue: callers embed a qlink in their own structs and get it
+ * back from iqueue_pop (container_of recovers the struct), so push and pop
+ * never allocate. Producers swap the tail, consumers take the head
+ * spin-lock as in queue_pop. A link may be pushed again, here or into
+ * another iqueue, as soon as iqueue_pop has returned it. */
+struct qlink {
+    qlink *next;
+};
+
+struct iqueue {
+    qlink *head;
+    qlink *tail;
+    qlink stub;
 };
 
 int queue_new(queue *q);
+int queue_new_kind(queue *q, queue_kind kind, int capacity);
+int queue_parse_kind(const char *name, queue_kind *kind);
 int queue_delete(queue *q);
 int queue_push(queue *q, void *val);
 void* queue_pop(queue *q);
 void queue_print(queue *q, int num_ops);
 
+void iqueue_new(iqueue *q);
+void iqueue_push(iqueue *q, qlink *link);
+qlink* iqueue_pop(iqueue *q);
+
 #endif //MULTICORE_LF_QUEUE_H
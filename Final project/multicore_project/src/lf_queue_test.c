@@ -1,4 +1,7 @@
 #include "lf_queue.h"
+#include "affinity.h"
+#include "pool.h"
+#include "bench.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,29 +9,158 @@
 #include <unistd.h>
 #include <omp.h>
 #include <getopt.h>
+#include <sched.h>
+
+#define RING_CAPACITY 1024
+
+/* a caller-owned message for the intrusive queue */
+typedef struct item {
+    long seq;
+    qlink link;
+} item;
+
+
+/* P producers and C consumers on dedicated threads pass num_ops items.
+ * Each item carries its send time: the scheduled one under an offered
+ * rate, so that queueing behind a slow consumer counts as latency. */
+static void run_topology(queue *q, int producers, int consumers, int num_ops,
+                         double rate, affinity_policy policy, int numa_node) {
+    long *lat = (long*) malloc(num_ops * sizeof(long));
+    long received = 0;
+    long start = bench_now_ns();
+
+    # pragma omp parallel num_threads(producers + consumers)
+    {
+    int tid = omp_get_thread_num();
+    affinity_pin(policy, numa_node, tid);
+
+    if (tid < producers) {
+        pool_reserve(sizeof(node), num_ops / producers + 1);
+        long k = 0;
+        for (long i = tid; i < num_ops; i += producers, k++) {
+            long stamp = bench_schedule(start, rate, producers, tid, k);
+            if (stamp < 0) {
+                stamp = bench_now_ns();
+            } else {
+                bench_wait_until(stamp);
+            }
+            while (queue_push(q, (void *) stamp) != 0)
+                sched_yield();
+        }
+    } else {
+        while (__atomic_load_n(&received, __ATOMIC_RELAXED) < num_ops) {
+            long stamp = (long) queue_pop(q);
+            if (stamp == 0) {
+                sched_yield();
+                continue;
+            }
+            lat[__sync_fetch_and_add(&received, 1)] = bench_now_ns() - stamp;
+        }
+    }
+    }
+
+    bench_report(producers, consumers, rate, lat, num_ops, bench_now_ns() - start);
+    free(lat);
+}
 
 
 int main(int argc, char** argv) {
+    affinity_policy policy = AFFINITY_NONE;
+    int numa_node = 0;
+    queue_kind kind = QUEUE_MPMC;
+    int producers = 0, consumers = 0;
+    double rate = 0;
+    int intrusive = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:k:P:C:R:i")) != -1) {
+        switch (opt) {
+        case 'a':
+            if (affinity_parse(optarg, &policy, &numa_node) != 0) {
+                printf("unknown affinity policy: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'k':
+            if (queue_parse_kind(optarg, &kind) != 0) {
+                printf("unknown queue kind: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'P':
+            producers = strtol(optarg, NULL, 10);
+            break;
+        case 'C':
+            consumers = strtol(optarg, NULL, 10);
+            break;
+        case 'R':
+            rate = strtod(optarg, NULL);
+            break;
+        case 'i':
+            intrusive = 1;
+            break;
+        default:
+            printf("usage: %s [-a none|compact|scatter|node[:N]] [-k mpmc|mpsc|spsc] [-P producers] [-C consumers] [-R ops_per_sec] [-i] threads ops push_ratio\n", argv[0]);
+            exit(1);
+        }
+    }
+
     if ((argc - optind) < 3) {
         printf("I need three fixed arguments!");
         exit(1);
     }
 
-    int num_threads = strtol(argv[1], NULL, 10);
-    int num_ops = strtol(argv[2], NULL, 10);
-    float push_ratio = strtof(argv[3], NULL);
+    int num_threads = strtol(argv[optind], NULL, 10);
+    int num_ops = strtol(argv[optind + 1], NULL, 10);
+    float push_ratio = strtof(argv[optind + 2], NULL);
 
     time_t t;
     srand((unsigned) time(&t));
 
     queue q;
-    queue_new(&q);
+    queue_new_kind(&q, kind, RING_CAPACITY);
+
+    /* -P / -C and the specialized kinds run dedicated producers and
+     * consumers, push_ratio is ignored */
+    if (producers > 0 || consumers > 0 || kind != QUEUE_MPMC) {
+        if (consumers < 1 || kind != QUEUE_MPMC)
+            consumers = 1;
+        if (producers < 1)
+            producers = (num_threads > consumers) ? num_threads - consumers : 1;
+        if (kind == QUEUE_SPSC)
+            producers = 1;
+        run_topology(&q, producers, consumers, num_ops, rate, policy, numa_node);
+        queue_delete(&q);
+        return 0;
+    }
+
+    /* -i: one preallocated item per operation, pushed by its embedded link */
+    iqueue iq;
+    iqueue_new(&iq);
+    item *items = intrusive ? (item*) malloc(num_ops * sizeof(item)) : NULL;
+    long checksum = 0;
 
-    # pragma omp parallel for num_threads(num_threads)
+    # pragma omp parallel num_threads(num_threads) reduction(+:checksum)
+    {
+    /* pin first, then pre-touch this thread's nodes on its own NUMA node */
+    affinity_pin(policy, numa_node, omp_get_thread_num());
+    pool_reserve(sizeof(node), num_ops / num_threads + 1);
+
+    # pragma omp for
     for (int i = 0; i < num_ops; i++) {
         int num  = rand();
         float r = (float) rand() / (float) RAND_MAX;
-        if (r < push_ratio)  {
+        if (r < push_ratio && intrusive)  {
+            items[i].seq = num;
+            iqueue_push(&iq, &items[i].link);
+        } else if (intrusive) {
+            qlink *link = iqueue_pop(&iq);
+            if (link != NULL)
+                checksum += container_of(link, item, link)->seq;
+
+            #ifdef DEBUG
+            printf("item %s by %d\n", (link != NULL) ? "poped" : "not found", omp_get_thread_num());
+            #endif
+        } else if (r < push_ratio)  {
             queue_push(&q, (void *) num);
 
             #ifdef DEBUG
@@ -46,9 +178,12 @@ int main(int argc, char** argv) {
             #endif
         }
     }
+    }
 
     #ifdef DEBUG
     queue_print(&q, num_ops);
+    if (intrusive)
+        printf("checksum of popped items: %ld\n", checksum);
     #endif
 
     return 0;
@@ -0,0 +1,91 @@
+#ifndef MULTICORE_LF_TQUEUE_H
+#define MULTICORE_LF_TQUEUE_H
+
+#include "pool.h"
+#include <string.h>
+#include <errno.h>
+
+#define CAS(old_ptr,old_val,new_val) \
+    (__sync_bool_compare_and_swap(old_ptr, old_val, new_val))
+
+/* Typed variant of lf_queue (MPMC, same algorithm) whose payload lives
+ * inline in the node: one pool allocation per message instead of a node
+ * plus a separately allocated payload, and no pointer chase on pop.
+ * Payloads are copied in and out, so keep them small; nodes up to
+ * POOL_MAX_SIZE bytes come from the per-thread pool.
+ *
+ * DEFINE_TYPED_QUEUE(msg_queue, struct msg) defines the types msg_queue
+ * and msg_queue_node and the functions
+ *   int  msg_queue_new(msg_queue *q);
+ *   void msg_queue_delete(msg_queue *q);
+ *   int  msg_queue_push(msg_queue *q, const struct msg *val);
+ *   int  msg_queue_pop(msg_queue *q, struct msg *val);  1, or 0 if empty
+ */
+#define DEFINE_TYPED_QUEUE(name, type)                                      \
+                                                                            \
+typedef struct name##_node name##_node;                                     \
+                                                                            \
+struct name##_node {                                                        \
+    name##_node *next;                                                      \
+    type val;                                                               \
+};                                                                          \
+                                                                            \
+typedef struct name {                                                       \
+    name##_node *head;                                                      \
+    name##_node *tail;                                                      \
+} name;                                                                     \
+                                                                            \
+static inline int name##_new(name *q) {                                     \
+    name##_node *sentinel = pool_alloc(sizeof(name##_node));                \
+    if (!sentinel) {                                                        \
+        return -errno;                                                      \
+    }                                                                       \
+    sentinel->next = NULL;                                                  \
+    q->head = q->tail = sentinel;                                           \
+    return 0;                                                               \
+}                                                                           \
+                                                                            \
+static inline void name##_delete(name *q) {                                 \
+    name##_node *curr = q->head;                                            \
+    while (curr != NULL) {                                                  \
+        name##_node *next = curr->next;                                     \
+        pool_free(curr, sizeof(name##_node));                               \
+        curr = next;                                                        \
+    }                                                                       \
+    q->head = q->tail = NULL;                                               \
+}                                                                           \
+                                                                            \
+static inline int name##_push(name *q, const type *val) {                   \
+    name##_node *new_node = pool_alloc(sizeof(name##_node));                \
+    if (!new_node) {                                                        \
+        return -errno;                                                      \
+    }                                                                       \
+    memcpy(&new_node->val, val, sizeof(type));                              \
+    new_node->next = NULL;                                                  \
+    name##_node *tail;                                                      \
+    do {                                                                    \
+        tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);                 \
+    } while (!CAS(&q->tail, tail, new_node));                               \
+    __atomic_store_n(&tail->next, new_node, __ATOMIC_RELEASE);              \
+    return 0;                                                               \
+}                                                                           \
+                                                                            \
+/* the payload is copied out while the head spin-lock is held */            \
+static inline int name##_pop(name *q, type *val) {                          \
+    name##_node *head;                                                      \
+    do {                                                                    \
+        head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);                 \
+    } while (head == NULL || !CAS(&q->head, head, NULL));                   \
+                                                                            \
+    name##_node *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);     \
+    if (next == NULL) {                                                     \
+        __atomic_store_n(&q->head, head, __ATOMIC_RELEASE);                 \
+        return 0;                                                           \
+    }                                                                       \
+    memcpy(val, &next->val, sizeof(type));                                  \
+    __atomic_store_n(&q->head, next, __ATOMIC_RELEASE);                     \
+    pool_free(head, sizeof(name##_node));                                   \
+    return 1;                                                               \
+}
+
+#endif //MULTICORE_LF_TQUEUE_H
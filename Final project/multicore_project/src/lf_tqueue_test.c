@@ -0,0 +1,104 @@
+#include "lf_tqueue.h"
+#include "lf_queue.h"
+#include "affinity.h"
+#include "pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+#include <getopt.h>
+
+/* a 48-byte message: with the link its node fills one pool class */
+typedef struct message {
+    long seq;
+    long sender;
+    int body[8];
+} message;
+
+DEFINE_TYPED_QUEUE(msg_queue, message)
+
+
+int main(int argc, char** argv) {
+    affinity_policy policy = AFFINITY_NONE;
+    int numa_node = 0;
+    int baseline = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:b")) != -1) {
+        switch (opt) {
+        case 'a':
+            if (affinity_parse(optarg, &policy, &numa_node) != 0) {
+                printf("unknown affinity policy: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'b':
+            baseline = 1;
+            break;
+        default:
+            printf("usage: %s [-a none|compact|scatter|node[:N]] [-b] threads ops push_ratio\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    if ((argc - optind) < 3) {
+        printf("I need three fixed arguments!");
+        exit(1);
+    }
+
+    int num_threads = strtol(argv[optind], NULL, 10);
+    int num_ops = strtol(argv[optind + 1], NULL, 10);
+    float push_ratio = strtof(argv[optind + 2], NULL);
+
+    time_t t;
+    srand((unsigned) time(&t));
+
+    /* -b: the same messages malloc'ed and passed by pointer through lf_queue */
+    msg_queue tq;
+    queue q;
+    msg_queue_new(&tq);
+    queue_new(&q);
+    long checksum = 0;
+
+    # pragma omp parallel num_threads(num_threads) reduction(+:checksum)
+    {
+    affinity_pin(policy, numa_node, omp_get_thread_num());
+    pool_reserve(baseline ? sizeof(node) : sizeof(msg_queue_node),
+                 num_ops / num_threads + 1);
+
+    # pragma omp for
+    for (int i = 0; i < num_ops; i++) {
+        float r = (float) rand() / (float) RAND_MAX;
+        if (r < push_ratio)  {
+            message m = { .seq = i, .sender = omp_get_thread_num() };
+            if (baseline) {
+                message *p = (message*) malloc(sizeof(message));
+                *p = m;
+                queue_push(&q, p);
+            } else {
+                msg_queue_push(&tq, &m);
+            }
+        } else {
+            if (baseline) {
+                message *p = (message*) queue_pop(&q);
+                if (p != NULL) {
+                    checksum += p->seq;
+                    free(p);
+                }
+            } else {
+                message m;
+                if (msg_queue_pop(&tq, &m))
+                    checksum += m.seq;
+            }
+        }
+    }
+    }
+
+    #ifdef DEBUG
+    printf("checksum of popped messages: %ld\n", checksum);
+    #endif
+
+    msg_queue_delete(&tq);
+    return 0;
+}
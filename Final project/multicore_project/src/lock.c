@@ -0,0 +1,201 @@
+#include "lock.h"
+#include "affinity.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_pause() (__builtin_ia32_pause())
+#else
+#define cpu_pause() ((void) 0)
+#endif
+
+/* spins before a waiter yields its cpu; FIFO locks stall badly when
+ * the next waiter in line is descheduled (more threads than cpus) */
+#define SPINS_BEFORE_YIELD 1024
+
+#define XCHG(ptr,val) (__atomic_exchange_n(ptr, val, __ATOMIC_ACQ_REL))
+#define LOAD(ptr) (__atomic_load_n(ptr, __ATOMIC_ACQUIRE))
+#define STORE(ptr,val) (__atomic_store_n(ptr, val, __ATOMIC_RELEASE))
+
+/* mcs_qnode.locked states; GRANTED_GLOBAL is only used by the cohort lock */
+#define WAITING 1
+#define GRANTED 0
+#define GRANTED_GLOBAL 2
+
+static _Thread_local mcs_qnode mcs_self;
+static _Thread_local mcs_qnode cohort_self;
+static _Thread_local int cohort_node;
+static _Thread_local clh_qnode *clh_self;
+static _Thread_local clh_qnode *clh_pred;
+
+
+static void cpu_relax(int *spins) {
+    if (++(*spins) < SPINS_BEFORE_YIELD) {
+        cpu_pause();
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+
+/* MCS */
+
+static int mcs_acquire_node(mcs_lock *l, mcs_qnode *self) {
+    self->next = NULL;
+    self->locked = WAITING;
+    mcs_qnode *pred = XCHG(&l->tail, self);
+    if (pred == NULL) {
+        return GRANTED;
+    }
+    STORE(&pred->next, self);
+
+    int state, spins = 0;
+    while ((state = LOAD(&self->locked)) == WAITING) {
+        cpu_relax(&spins);
+    }
+    return state;
+}
+
+
+static void mcs_release_node(mcs_lock *l, mcs_qnode *self, int state) {
+    mcs_qnode *next = LOAD(&self->next);
+    if (next == NULL) {
+        mcs_qnode *expected = self;
+        if (__atomic_compare_exchange_n(&l->tail, &expected, NULL, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        /* a successor swapped the tail but has not linked itself yet */
+        int spins = 0;
+        while ((next = LOAD(&self->next)) == NULL) {
+            cpu_relax(&spins);
+        }
+    }
+    STORE(&next->locked, state);
+}
+
+
+void mcs_init(mcs_lock *l) {
+    l->tail = NULL;
+}
+
+
+void mcs_acquire(mcs_lock *l) {
+    mcs_acquire_node(l, &mcs_self);
+}
+
+
+void mcs_release(mcs_lock *l) {
+    mcs_release_node(l, &mcs_self, GRANTED);
+}
+
+
+/* CLH */
+
+static clh_qnode* clh_qnode_new(int locked) {
+    clh_qnode *n = (clh_qnode*) aligned_alloc(64, sizeof(clh_qnode));
+    n->locked = locked;
+    return n;
+}
+
+
+void clh_init(clh_lock *l) {
+    l->tail = clh_qnode_new(0);
+}
+
+
+void clh_acquire(clh_lock *l) {
+    if (clh_self == NULL) {
+        clh_self = clh_qnode_new(0);
+    }
+    clh_self->locked = 1;
+    clh_qnode *pred = XCHG(&l->tail, clh_self);
+    int spins = 0;
+    while (LOAD(&pred->locked)) {
+        cpu_relax(&spins);
+    }
+    clh_pred = pred;
+}
+
+
+void clh_release(clh_lock *l) {
+    (void) l;
+    STORE(&clh_self->locked, 0);
+    /* our node now belongs to the successor; recycle the predecessor's */
+    clh_self = clh_pred;
+}
+
+
+void clh_destroy(clh_lock *l) {
+    free(l->tail);
+    l->tail = NULL;
+}
+
+
+/* Ticket lock, used as the cohort's global lock because it may be released
+ * by a different thread than the one that acquired it. */
+
+void ticket_init(ticket_lock *l) {
+    l->next = 0;
+    l->owner = 0;
+}
+
+
+void ticket_acquire(ticket_lock *l) {
+    unsigned ticket = __sync_fetch_and_add(&l->next, 1);
+    int spins = 0;
+    while (LOAD(&l->owner) != ticket) {
+        cpu_relax(&spins);
+    }
+}
+
+
+void ticket_release(ticket_lock *l) {
+    STORE(&l->owner, l->owner + 1);
+}
+
+
+/* Cohort */
+
+void cohort_init(cohort_lock *l) {
+    ticket_init(&l->global);
+    l->num_nodes = affinity_num_nodes();
+    l->local = (cohort_local*) aligned_alloc(64, l->num_nodes * sizeof(cohort_local));
+    for (int n = 0; n < l->num_nodes; n++) {
+        mcs_init(&l->local[n].lock);
+        l->local[n].handoffs = 0;
+    }
+}
+
+
+void cohort_acquire(cohort_lock *l) {
+    int n = affinity_current_node() % l->num_nodes;
+    if (mcs_acquire_node(&l->local[n].lock, &cohort_self) != GRANTED_GLOBAL) {
+        ticket_acquire(&l->global);
+    }
+    /* release on the node we queued on, even if we migrate meanwhile */
+    cohort_node = n;
+}
+
+
+void cohort_release(cohort_lock *l) {
+    cohort_local *local = &l->local[cohort_node];
+    if (LOAD(&cohort_self.next) != NULL && local->handoffs < COHORT_MAX_HANDOFFS) {
+        /* a waiter on our node: pass it the global lock as well */
+        local->handoffs++;
+        mcs_release_node(&local->lock, &cohort_self, GRANTED_GLOBAL);
+        return;
+    }
+    local->handoffs = 0;
+    ticket_release(&l->global);
+    mcs_release_node(&local->lock, &cohort_self, GRANTED);
+}
+
+
+void cohort_destroy(cohort_lock *l) {
+    free(l->local);
+    l->local = NULL;
+}
@@ -0,0 +1,98 @@
+#ifndef MULTICORE_LOCK_H
+#define MULTICORE_LOCK_H
+
+#include <omp.h>
+
+/* Lock behind the blocking containers, picked at compile time:
+ *   -DLOCK_MCS     MCS queue lock, each waiter spins on its own node
+ *   -DLOCK_CLH     CLH queue lock, each waiter spins on its predecessor
+ *   -DLOCK_COHORT  cohort lock: a ticket lock between NUMA nodes and an MCS
+ *                  lock per node, handed over inside a node while it has
+ *                  waiters (up to COHORT_MAX_HANDOFFS times in a row)
+ *   otherwise      omp_lock_t
+ * The queue nodes are per thread, so a thread may hold one of these locks
+ * at a time, which is all the containers need. */
+
+#define COHORT_MAX_HANDOFFS 64
+
+typedef struct mcs_qnode mcs_qnode;
+typedef struct clh_qnode clh_qnode;
+
+struct mcs_qnode {
+    mcs_qnode *next;
+    int locked;
+} __attribute__((aligned(64)));
+
+struct clh_qnode {
+    int locked;
+} __attribute__((aligned(64)));
+
+typedef struct mcs_lock {
+    mcs_qnode *tail;
+} mcs_lock;
+
+typedef struct clh_lock {
+    clh_qnode *tail;
+} clh_lock;
+
+typedef struct ticket_lock {
+    unsigned next;
+    unsigned owner;
+} ticket_lock;
+
+typedef struct cohort_local {
+    mcs_lock lock;
+    int handoffs;      /* consecutive handoffs inside this node */
+} __attribute__((aligned(64))) cohort_local;
+
+typedef struct cohort_lock {
+    ticket_lock global __attribute__((aligned(64)));
+    int num_nodes;
+    cohort_local *local;
+} cohort_lock;
+
+void mcs_init(mcs_lock *l);
+void mcs_acquire(mcs_lock *l);
+void mcs_release(mcs_lock *l);
+
+void clh_init(clh_lock *l);
+void clh_acquire(clh_lock *l);
+void clh_release(clh_lock *l);
+void clh_destroy(clh_lock *l);
+
+void ticket_init(ticket_lock *l);
+void ticket_acquire(ticket_lock *l);
+void ticket_release(ticket_lock *l);
+
+void cohort_init(cohort_lock *l);
+void cohort_acquire(cohort_lock *l);
+void cohort_release(cohort_lock *l);
+void cohort_destroy(cohort_lock *l);
+
+#if defined(LOCK_MCS)
+typedef mcs_lock lock_t;
+#define omp_on(lock) (mcs_acquire(&lock))
+#define omp_off(lock) (mcs_release(&lock))
+#define omp_init(lock) (mcs_init(&lock))
+#define omp_destroy(lock) ((void) (lock))
+#elif defined(LOCK_CLH)
+typedef clh_lock lock_t;
+#define omp_on(lock) (clh_acquire(&lock))
+#define omp_off(lock) (clh_release(&lock))
+#define omp_init(lock) (clh_init(&lock))
+#define omp_destroy(lock) (clh_destroy(&lock))
+#elif defined(LOCK_COHORT)
+typedef cohort_lock lock_t;
+#define omp_on(lock) (cohort_acquire(&lock))
+#define omp_off(lock) (cohort_release(&lock))
+#define omp_init(lock) (cohort_init(&lock))
+#define omp_destroy(lock) (cohort_destroy(&lock))
+#else
+typedef omp_lock_t lock_t;
+#define omp_on(lock) (omp_set_lock(&lock))
+#define omp_off(lock) (omp_unset_lock(&lock))
+#define omp_init(lock) (omp_init_lock(&lock))
+#define omp_destroy(lock) (omp_destroy_lock(&lock))
+#endif
+
+#endif //MULTICORE_LOCK_H
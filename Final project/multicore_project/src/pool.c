@@ -0,0 +1,97 @@
+#include "pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_CLASSES (POOL_MAX_SIZE / 16)
+#define POOL_CHUNK (64 * 1024)
+
+typedef struct pool_block pool_block;
+
+struct pool_block {
+    pool_block *next;
+};
+
+static _Thread_local pool_block *free_list[POOL_CLASSES];
+static _Thread_local char *chunk_cur[POOL_CLASSES];
+static _Thread_local char *chunk_end[POOL_CLASSES];
+
+
+static int size_class(size_t size) {
+    return (int) ((size + 15) / 16) - 1;
+}
+
+
+/* Allocate a fresh chunk of at least bytes and touch every page of it
+ * from the calling thread. */
+static int pool_grow(int cls, size_t bytes) {
+    if (bytes < POOL_CHUNK) {
+        bytes = POOL_CHUNK;
+    }
+    bytes = (bytes + 63) & ~(size_t) 63;
+    char *chunk = (char*) aligned_alloc(64, bytes);
+    if (chunk == NULL) {
+        return -1;
+    }
+    memset(chunk, 0, bytes);
+    chunk_cur[cls] = chunk;
+    chunk_end[cls] = chunk + bytes;
+    return 0;
+}
+
+
+void* pool_alloc(size_t size) {
+    if (size == 0 || size > POOL_MAX_SIZE) {
+        return malloc(size);
+    }
+
+    int cls = size_class(size);
+    size_t obj_size = (size_t) (cls + 1) * 16;
+
+    pool_block *block = free_list[cls];
+    if (block != NULL) {
+        free_list[cls] = block->next;
+        return block;
+    }
+
+    if (chunk_cur[cls] == NULL || chunk_cur[cls] + obj_size > chunk_end[cls]) {
+        if (pool_grow(cls, POOL_CHUNK) != 0) {
+            return NULL;
+        }
+    }
+    void *p = chunk_cur[cls];
+    chunk_cur[cls] += obj_size;
+    return p;
+}
+
+
+void pool_free(void *p, size_t size) {
+    if (p == NULL) {
+        return;
+    }
+    if (size == 0 || size > POOL_MAX_SIZE) {
+        free(p);
+        return;
+    }
+
+    int cls = size_class(size);
+    pool_block *block = (pool_block*) p;
+    block->next = free_list[cls];
+    free_list[cls] = block;
+}
+
+
+/* Make sure the calling thread can hand out count nodes of size
+ * without touching new pages; call it right after pinning the thread. */
+int pool_reserve(size_t size, size_t count) {
+    if (size == 0 || size > POOL_MAX_SIZE) {
+        return 0;
+    }
+
+    int cls = size_class(size);
+    size_t bytes = count * (size_t) (cls + 1) * 16;
+    if (chunk_cur[cls] != NULL && chunk_cur[cls] + bytes <= chunk_end[cls]) {
+        return 0;
+    }
+    return pool_grow(cls, bytes);
+}
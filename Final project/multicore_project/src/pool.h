@@ -0,0 +1,18 @@
+#ifndef MULTICORE_POOL_H
+#define MULTICORE_POOL_H
+
+#include <stddef.h>
+
+/* Per-thread node pool.
+ * Every thread carves nodes out of chunks it allocated and touched itself,
+ * so with pinned threads the pages land on the thread's NUMA node
+ * (first-touch). Freed nodes go to the freeing thread's list.
+ * Sizes are rounded up to 16 bytes; anything above POOL_MAX_SIZE
+ * falls back to malloc. */
+#define POOL_MAX_SIZE 64
+
+void* pool_alloc(size_t size);
+void pool_free(void *p, size_t size);
+int pool_reserve(size_t size, size_t count);
+
+#endif //MULTICORE_POOL_H
@@ -0,0 +1,198 @@
+#include "pq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <sched.h>
+
+#define HEAP_INITIAL_CAPACITY 1024
+
+/* failed samplings of empty heaps before pq_delete_min scans them all */
+#define EMPTY_PROBES 8
+
+/* failed try-locks before a thread yields its cpu */
+#define TRIES_BEFORE_YIELD 64
+
+static unsigned seed_counter;
+static _Thread_local unsigned rand_state;
+
+
+/* per-thread xorshift, rand() would serialize the threads */
+static unsigned next_rand(void) {
+    if (rand_state == 0) {
+        rand_state = __sync_add_and_fetch(&seed_counter, 1) * 2654435761u;
+        if (rand_state == 0)
+            rand_state = 1;
+    }
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+
+static int heap_trylock(heap *h) {
+    return h->lock == 0 && CAS(&h->lock, 0, 1);
+}
+
+
+static void backoff(int *tries) {
+    if (++(*tries) == TRIES_BEFORE_YIELD) {
+        *tries = 0;
+        sched_yield();
+    }
+}
+
+
+static void heap_unlock(heap *h) {
+    __atomic_store_n(&h->lock, 0, __ATOMIC_RELEASE);
+}
+
+
+static void heap_set_top(heap *h) {
+    __atomic_store_n(&h->top, (h->size > 0) ? h->keys[0] : INT_MAX, __ATOMIC_RELAXED);
+}
+
+
+static int heap_push(heap *h, int val) {
+    if (h->size == h->capacity) {
+        int *keys = (int*) realloc(h->keys, 2 * h->capacity * sizeof(int));
+        if (!keys) {
+            return -errno;
+        }
+        h->keys = keys;
+        h->capacity *= 2;
+    }
+    int i = h->size++;
+    while (i > 0 && h->keys[(i - 1) / 2] > val) {
+        h->keys[i] = h->keys[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h->keys[i] = val;
+    heap_set_top(h);
+    return 0;
+}
+
+
+static int heap_pop(heap *h) {
+    int res = h->keys[0];
+    int last = h->keys[--h->size];
+    int i = 0;
+    while (2 * i + 1 < h->size) {
+        int child = 2 * i + 1;
+        if (child + 1 < h->size && h->keys[child + 1] < h->keys[child])
+            child++;
+        if (h->keys[child] >= last)
+            break;
+        h->keys[i] = h->keys[child];
+        i = child;
+    }
+    h->keys[i] = last;
+    heap_set_top(h);
+    return res;
+}
+
+
+int pq_new(pq *q, int num_heaps) {
+    if (num_heaps < 1)
+        num_heaps = 1;
+    q->heaps = (heap*) aligned_alloc(64, num_heaps * sizeof(heap));
+    if (!q->heaps) {
+        return -errno;
+    }
+    memset(q->heaps, 0, num_heaps * sizeof(heap));
+    q->num_heaps = num_heaps;
+    for (int i = 0; i < num_heaps; i++) {
+        q->heaps[i].top = INT_MAX;
+        q->heaps[i].capacity = HEAP_INITIAL_CAPACITY;
+        q->heaps[i].keys = (int*) malloc(HEAP_INITIAL_CAPACITY * sizeof(int));
+        if (!q->heaps[i].keys) {
+            int err = errno;
+            pq_delete(q);   /* frees the keys allocated so far */
+            return -err;
+        }
+    }
+    return 0;
+}
+
+
+void pq_delete(pq *q) {
+    for (int i = 0; i < q->num_heaps; i++) {
+        free(q->heaps[i].keys);
+    }
+    free(q->heaps);
+    memset(q, 0, sizeof(pq));
+}
+
+
+/* val must be smaller than INT_MAX, which marks an empty heap */
+int pq_insert(pq *q, int val) {
+    heap *h;
+    int tries = 0;
+    while (1) {
+        h = &q->heaps[next_rand() % q->num_heaps];
+        if (heap_trylock(h))
+            break;
+        backoff(&tries);
+    }
+
+    int res = heap_push(h, val);
+    heap_unlock(h);
+    return res;
+}
+
+
+/* Pop the smaller top of two random heaps into *val and return 1, or
+ * return 0 once every heap is empty. The key is one of the smallest,
+ * within a rank that grows with num_heaps. */
+int pq_delete_min(pq *q, int *val) {
+    int empty_probes = 0, tries = 0;
+    while (1) {
+        heap *h = &q->heaps[next_rand() % q->num_heaps];
+        heap *other = &q->heaps[next_rand() % q->num_heaps];
+        if (__atomic_load_n(&other->top, __ATOMIC_RELAXED) <
+            __atomic_load_n(&h->top, __ATOMIC_RELAXED))
+            h = other;
+
+        if (__atomic_load_n(&h->top, __ATOMIC_RELAXED) == INT_MAX) {
+            if (++empty_probes < EMPTY_PROBES)
+                continue;
+            /* the samples keep coming up empty: look at every heap */
+            h = NULL;
+            for (int i = 0; i < q->num_heaps; i++) {
+                if (__atomic_load_n(&q->heaps[i].top, __ATOMIC_RELAXED) != INT_MAX) {
+                    h = &q->heaps[i];
+                    break;
+                }
+            }
+            if (h == NULL)
+                return 0;
+            empty_probes = 0;
+        }
+
+        if (!heap_trylock(h)) {
+            backoff(&tries);
+            continue;
+        }
+        if (h->size == 0) {
+            heap_unlock(h);
+            continue;
+        }
+        *val = heap_pop(h);
+        heap_unlock(h);
+        return 1;
+    }
+}
+
+
+/* debuggin API */
+void pq_print(pq *q) {
+    for (int i = 0; i < q->num_heaps; i++) {
+        printf("-> heap %d: [", i);
+        for (int j = 0; j < q->heaps[i].size; j++) {
+            printf("%d,", q->heaps[i].keys[j]);
+        }
+        printf("]\n");
+    }
+}
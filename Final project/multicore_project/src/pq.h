@@ -0,0 +1,34 @@
+#ifndef MULTICORE_PQ_H
+#define MULTICORE_PQ_H
+
+#define CAS(ptr,old_val,new_val) \
+    (__sync_bool_compare_and_swap(ptr, old_val, new_val))
+
+typedef struct heap heap;
+typedef struct pq pq;
+
+/* Relaxed concurrent priority queue (MultiQueue): num_heaps sequential
+ * min-heaps, each behind a try-lock. Inserts go to a random heap,
+ * pq_delete_min pops the smaller top of two random heaps. With
+ * num_heaps = c * threads, c is the relaxation factor: 1 heap is a strict
+ * priority queue, more heaps trade ordering for less contention. */
+struct heap {
+    int lock;
+    int top;           /* cached minimum, INT_MAX when empty */
+    int size;
+    int capacity;
+    int *keys;
+} __attribute__((aligned(64)));
+
+struct pq {
+    heap *heaps;
+    int num_heaps;
+};
+
+int pq_new(pq *q, int num_heaps);
+void pq_delete(pq *q);
+int pq_insert(pq *q, int val);
+int pq_delete_min(pq *q, int *val);
+void pq_print(pq *q);
+
+#endif //MULTICORE_PQ_H
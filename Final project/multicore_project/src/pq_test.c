@@ -0,0 +1,136 @@
+#include "pq.h"
+#include "affinity.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+#include <getopt.h>
+
+/* keys in the queue and pops measured by the -e rank error sample */
+#define RANK_KEYS 10000
+#define RANK_POPS 1000
+
+
+/* The rank error of a pop is the number of keys in the queue smaller than
+ * the popped one: 0 for a strict priority queue. RANK_POPS pops from a
+ * queue of num_heaps heaps kept at RANK_KEYS random keys, run by a single
+ * thread after the timed part, so the heaps can be read directly. */
+static void rank_error_sample(int num_heaps) {
+    pq q;
+    if (pq_new(&q, num_heaps) != 0) {
+        printf("cannot allocate the rank error sample\n");
+        return;
+    }
+    for (int i = 0; i < RANK_KEYS; i++)
+        pq_insert(&q, rand());
+
+    long total = 0;
+    long max = 0;
+    for (int p = 0; p < RANK_POPS; p++) {
+        int key;
+        pq_delete_min(&q, &key);
+        long rank = 0;
+        for (int i = 0; i < q.num_heaps; i++)
+            for (int j = 0; j < q.heaps[i].size; j++)
+                if (q.heaps[i].keys[j] < key)
+                    rank++;
+        total += rank;
+        if (rank > max)
+            max = rank;
+        pq_insert(&q, rand());
+    }
+    printf("rank error over %d pops from %d keys in %d heaps: mean %.2f, max %ld\n",
+           RANK_POPS, RANK_KEYS, q.num_heaps, (double) total / RANK_POPS, max);
+    pq_delete(&q);
+}
+
+
+int main(int argc, char** argv) {
+    affinity_policy policy = AFFINITY_NONE;
+    int numa_node = 0;
+    int relaxation = 2;
+    int rank_error = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:c:e")) != -1) {
+        switch (opt) {
+        case 'a':
+            if (affinity_parse(optarg, &policy, &numa_node) != 0) {
+                printf("unknown affinity policy: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'c':
+            relaxation = strtol(optarg, NULL, 10);
+            break;
+        case 'e':
+            rank_error = 1;
+            break;
+        default:
+            printf("usage: %s [-a none|compact|scatter|node[:N]] [-c heaps_per_thread] [-e] threads ops push_ratio\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    if ((argc - optind) < 3) {
+        printf("I need three fixed arguments!");
+        exit(1);
+    }
+
+    int num_threads = strtol(argv[optind], NULL, 10);
+    int num_ops = strtol(argv[optind + 1], NULL, 10);
+    float push_ratio = strtof(argv[optind + 2], NULL);
+
+    time_t t;
+    srand((unsigned) time(&t));
+
+    /* relaxation 0 asks for a single heap: a strict priority queue */
+    pq q;
+    if (pq_new(&q, relaxation * num_threads) != 0) {
+        printf("cannot allocate the queue\n");
+        exit(1);
+    }
+
+    long empty = 0;
+    # pragma omp parallel num_threads(num_threads) reduction(+:empty)
+    {
+    affinity_pin(policy, numa_node, omp_get_thread_num());
+
+    # pragma omp for
+    for (int i = 0; i < num_ops; i++) {
+        int num  = rand();
+        float r = (float) rand() / (float) RAND_MAX;
+        if (r < push_ratio)  {
+            pq_insert(&q, num);
+
+            #ifdef DEBUG
+            printf("num: %d inserting by %d\n", num, omp_get_thread_num());
+            #endif
+        } else {
+            int val;
+            int found = pq_delete_min(&q, &val);
+            empty += !found;
+
+            #ifdef DEBUG
+            if (!found) {
+                printf("empty queue by %d\n", omp_get_thread_num());
+            } else {
+                printf("num: %d poped by %d\n", val, omp_get_thread_num());
+            }
+            #endif
+        }
+    }
+    }
+
+    #ifdef DEBUG
+    pq_print(&q);
+    printf("pops from an empty queue: %ld\n", empty);
+    #endif
+    pq_delete(&q);
+
+    if (rank_error)
+        rank_error_sample(relaxation * num_threads);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "simd_search.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+static lower_bound_fn lower_bound_impl = keys_lower_bound_scalar;
+static const char *lower_bound_impl_name = "scalar";
+
+
+int keys_lower_bound_scalar(const int *keys, int count, int val) {
+    int i = 0;
+    while (i < count && keys[i] < val)
+        i++;
+    return i;
+}
+
+
+#ifdef HAVE_X86
+
+/* The keys are sorted, so the lower bound is the number of lanes where
+ * key < val: compare, movemask, popcount. */
+
+__attribute__((target("sse4.1,popcnt")))
+int keys_lower_bound_sse4(const int *keys, int count, int val) {
+    __m128i v = _mm_set1_epi32(val);
+    int res = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i k = _mm_loadu_si128((const __m128i*) (keys + i));
+        __m128i lt = _mm_cmpgt_epi32(v, k);
+        res += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(lt)));
+    }
+    for (; i < count; i++)
+        res += (keys[i] < val);
+    return res;
+}
+
+
+__attribute__((target("avx2,popcnt")))
+int keys_lower_bound_avx2(const int *keys, int count, int val) {
+    __m256i v = _mm256_set1_epi32(val);
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int res = 0;
+    for (int i = 0; i < count; i += 8) {
+        /* masked load: lanes past count are neither read nor counted */
+        __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), lane);
+        __m256i k = _mm256_maskload_epi32(keys + i, valid);
+        __m256i lt = _mm256_and_si256(_mm256_cmpgt_epi32(v, k), valid);
+        res += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(lt)));
+    }
+    return res;
+}
+
+
+__attribute__((constructor))
+static void lower_bound_select(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        lower_bound_impl = keys_lower_bound_avx2;
+        lower_bound_impl_name = "avx2";
+    } else if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt")) {
+        lower_bound_impl = keys_lower_bound_sse4;
+        lower_bound_impl_name = "sse4.1";
+    }
+}
+
+#else
+
+int keys_lower_bound_sse4(const int *keys, int count, int val) {
+    return keys_lower_bound_scalar(keys, count, val);
+}
+
+
+int keys_lower_bound_avx2(const int *keys, int count, int val) {
+    return keys_lower_bound_scalar(keys, count, val);
+}
+
+#endif
+
+
+int keys_lower_bound(const int *keys, int count, int val) {
+    return lower_bound_impl(keys, count, val);
+}
+
+
+const char* keys_lower_bound_name(void) {
+    return lower_bound_impl_name;
+}
+
+
+/* whether this cpu can run fn */
+int keys_lower_bound_supported(lower_bound_fn fn) {
+#ifdef HAVE_X86
+    __builtin_cpu_init();
+    if (fn == keys_lower_bound_avx2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    if (fn == keys_lower_bound_sse4)
+        return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt");
+#endif
+    return 1;
+}
@@ -0,0 +1,16 @@
+#ifndef MULTICORE_SIMD_SEARCH_H
+#define MULTICORE_SIMD_SEARCH_H
+
+/* Lower bound of val in the ascending array keys[0..count): the number of
+ * keys smaller than val. keys_lower_bound dispatches to the AVX2, SSE4.1
+ * or scalar version, picked once at startup from CPUID. */
+typedef int (*lower_bound_fn)(const int *keys, int count, int val);
+
+int keys_lower_bound(const int *keys, int count, int val);
+int keys_lower_bound_scalar(const int *keys, int count, int val);
+int keys_lower_bound_sse4(const int *keys, int count, int val);
+int keys_lower_bound_avx2(const int *keys, int count, int val);
+const char* keys_lower_bound_name(void);
+int keys_lower_bound_supported(lower_bound_fn fn);
+
+#endif //MULTICORE_SIMD_SEARCH_H
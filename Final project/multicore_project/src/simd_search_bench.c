@@ -0,0 +1,170 @@
+#include "ul_list.h"
+#include "simd_search.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <omp.h>
+
+#define IN_NODE_QUERIES 10000000
+
+/* one key per node, the layout of l_list / lf_list */
+typedef struct key_node key_node;
+
+struct key_node {
+    int val;
+    key_node *next;
+};
+
+
+static int compare_keys(const void *a, const void *b) {
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+
+/* n distinct random keys in ascending order; n is updated */
+static int* sorted_keys(int *n) {
+    int *keys = (int*) malloc(*n * sizeof(int));
+    for (int i = 0; i < *n; i++) {
+        keys[i] = rand();
+    }
+    qsort(keys, *n, sizeof(int), compare_keys);
+    int m = 0;
+    for (int i = 0; i < *n; i++) {
+        if (m == 0 || keys[i] != keys[m - 1])
+            keys[m++] = keys[i];
+    }
+    *n = m;
+    return keys;
+}
+
+
+static key_node* build_key_list(const int *keys, int n) {
+    key_node *tail = (key_node*) malloc(sizeof(key_node));
+    tail->val = INT_MAX;
+    tail->next = NULL;
+    key_node *head = tail;
+    for (int i = n - 1; i >= 0; i--) {
+        key_node *t = (key_node*) malloc(sizeof(key_node));
+        t->val = keys[i];
+        t->next = head;
+        head = t;
+    }
+    return head;
+}
+
+
+static node* build_unrolled(const int *keys, int n, int *num_nodes) {
+    *num_nodes = (n + NODE_KEYS - 1) / NODE_KEYS;
+    node *nodes = (node*) aligned_alloc(64, *num_nodes * sizeof(node));
+    for (int b = 0; b < *num_nodes; b++) {
+        node *curr = &nodes[b];
+        curr->count = 0;
+        for (int i = b * NODE_KEYS; i < n && curr->count < NODE_KEYS; i++) {
+            curr->keys[curr->count++] = keys[i];
+        }
+        curr->low = curr->keys[0];
+        curr->next = (b + 1 < *num_nodes) ? &nodes[b + 1] : NULL;
+    }
+    return nodes;
+}
+
+
+/* list_search's inner loop: one node and one compare per key */
+static double bench_key_walk(key_node *head, const int *queries, int num_queries, long *sink) {
+    double start = omp_get_wtime();
+    for (int q = 0; q < num_queries; q++) {
+        key_node *t = head;
+        while (t->val < queries[q])
+            t = t->next;
+        *sink += t->val;
+    }
+    return omp_get_wtime() - start;
+}
+
+
+/* the same walk over unrolled nodes, searching each node with fn */
+static double bench_node_walk(node *head, lower_bound_fn fn, const int *queries, int num_queries, long *sink) {
+    double start = omp_get_wtime();
+    for (int q = 0; q < num_queries; q++) {
+        node *n = head;
+        int pos;
+        while ((pos = fn(n->keys, n->count, queries[q])) == n->count && n->next != NULL)
+            n = n->next;
+        *sink += pos;
+    }
+    return omp_get_wtime() - start;
+}
+
+
+/* in-node search alone, on random nodes */
+static double bench_in_node(node *nodes, int num_nodes, lower_bound_fn fn, const int *queries, int num_queries, long *sink) {
+    double start = omp_get_wtime();
+    for (int q = 0; q < num_queries; q++) {
+        node *n = &nodes[(unsigned) queries[q] % num_nodes];
+        *sink += fn(n->keys, n->count, queries[q]);
+    }
+    return omp_get_wtime() - start;
+}
+
+
+int main(int argc, char** argv) {
+    int num_keys = (argc >= 3) ? strtol(argv[1], NULL, 10) : 0;
+    int num_queries = (argc >= 3) ? strtol(argv[2], NULL, 10) : 0;
+    if (num_keys < 1 || num_queries < 1) {
+        printf("usage: %s num_keys num_queries\n", argv[0]);
+        exit(1);
+    }
+
+    time_t t;
+    srand((unsigned) time(&t));
+
+    int *keys = sorted_keys(&num_keys);
+    if (num_keys < 1) {
+        /* nothing left to put in a node after deduplication */
+        printf("usage: %s num_keys num_queries\n", argv[0]);
+        exit(1);
+    }
+    int *queries = (int*) malloc(num_queries * sizeof(int));
+    for (int q = 0; q < num_queries; q++) {
+        queries[q] = rand();
+    }
+
+    int num_nodes;
+    key_node *key_list = build_key_list(keys, num_keys);
+    node *nodes = build_unrolled(keys, num_keys, &num_nodes);
+
+    const char *names[] = {"scalar", "sse4.1", "avx2"};
+    lower_bound_fn fns[] = {keys_lower_bound_scalar, keys_lower_bound_sse4, keys_lower_bound_avx2};
+    long sink = 0;
+
+    printf("keys: %d, nodes: %d, queries: %d, dispatch: %s\n",
+           num_keys, num_nodes, num_queries, keys_lower_bound_name());
+
+    double secs = bench_key_walk(key_list, queries, num_queries, &sink);
+    printf("walk    key list  (t->val < val) %10.1f ns/query\n", secs * 1e9 / num_queries);
+    for (int f = 0; f < 3; f++) {
+        if (!keys_lower_bound_supported(fns[f]))
+            continue;
+        secs = bench_node_walk(nodes, fns[f], queries, num_queries, &sink);
+        printf("walk    unrolled  %-14s %10.1f ns/query\n", names[f], secs * 1e9 / num_queries);
+    }
+
+    int in_node_queries = IN_NODE_QUERIES;
+    int *many = (int*) malloc(in_node_queries * sizeof(int));
+    for (int q = 0; q < in_node_queries; q++) {
+        many[q] = rand();
+    }
+    for (int f = 0; f < 3; f++) {
+        if (!keys_lower_bound_supported(fns[f]))
+            continue;
+        secs = bench_in_node(nodes, num_nodes, fns[f], many, in_node_queries, &sink);
+        printf("in-node lower bound %-12s %10.2f ns/query\n", names[f], secs * 1e9 / in_node_queries);
+    }
+
+    printf("(checksum %ld)\n", sink);
+    return 0;
+}
@@ -0,0 +1,222 @@
+#include "ul_list.h"
+#include "pool.h"
+#include "simd_search.h"
+#include "limits.h"
+#include <sched.h>
+
+#define LOAD(ptr) (__atomic_load_n(ptr, __ATOMIC_ACQUIRE))
+#define STORE(ptr,val) (__atomic_store_n(ptr, val, __ATOMIC_RELEASE))
+
+/* spins before a waiting thread yields its cpu */
+#define SPINS_BEFORE_YIELD 1024
+
+
+static void relax(int *spins) {
+    if (++(*spins) == SPINS_BEFORE_YIELD) {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+
+static node* node_new(int low) {
+    node *new_node = (node*) pool_alloc(sizeof(node));
+    new_node->version = 0;
+    new_node->count = 0;
+    new_node->low = low;
+    new_node->next = NULL;
+    return new_node;
+}
+
+
+static void node_lock(node *n) {
+    int spins = 0;
+    while (1) {
+        unsigned v = LOAD(&n->version);
+        if (!(v & 1) && CAS(&n->version, v, v + 1))
+            return;
+        relax(&spins);
+    }
+}
+
+
+static void node_unlock(node *n) {
+    STORE(&n->version, n->version + 1);
+}
+
+
+static unsigned read_begin(node *n) {
+    unsigned v;
+    int spins = 0;
+    while ((v = LOAD(&n->version)) & 1) {
+        relax(&spins);
+    }
+    return v;
+}
+
+
+static int read_validate(node *n, unsigned v) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&n->version, __ATOMIC_RELAXED) == v;
+}
+
+
+/* n is the live node responsible for val */
+static int owns(node *n, int val) {
+    node *next = n->next;
+    return n->count >= 0 && (next == NULL || val < next->low);
+}
+
+
+/* Walk to the last node whose low is <= val. Lows never change and
+ * unlinked nodes are never freed, so the walk needs no validation; the
+ * caller checks owns() under the node's lock or version. */
+static node* locate(list *l, int val) {
+    node *curr = l->head;
+    node *next;
+    while ((next = LOAD(&curr->next)) != NULL && next->low <= val)
+        curr = next;
+    return curr;
+}
+
+
+list* list_new(list *l) {
+    l->head = node_new(INT_MIN);
+    return l;
+}
+
+
+/* Move the upper half of the full, locked node n into a new node linked
+ * after it. The new node is returned locked. */
+static node* split(node *n) {
+    int half = NODE_KEYS / 2;
+    node *m = node_new(n->keys[half]);
+    m->version = 1;
+    for (int i = half; i < n->count; i++) {
+        m->keys[i - half] = n->keys[i];
+    }
+    m->count = n->count - half;
+    m->next = n->next;
+    STORE(&n->next, m);
+    n->count = half;
+    return m;
+}
+
+
+int list_insert(list *l, int val) {
+    while (1) {
+        node *n = locate(l, val);
+        node_lock(n);
+        if (!owns(n, val)) {
+            node_unlock(n);
+            continue;
+        }
+
+        int pos = keys_lower_bound(n->keys, n->count, val);
+        if (pos < n->count && n->keys[pos] == val) {
+            node_unlock(n);
+            return 0;
+        }
+
+        node *m = NULL;
+        node *target = n;
+        if (n->count == NODE_KEYS) {
+            m = split(n);
+            if (val >= m->low)
+                target = m;
+            pos = keys_lower_bound(target->keys, target->count, val);
+        }
+
+        for (int i = target->count; i > pos; i--) {
+            target->keys[i] = target->keys[i - 1];
+        }
+        target->keys[pos] = val;
+        target->count++;
+
+        if (m != NULL)
+            node_unlock(m);
+        node_unlock(n);
+        return 1;
+    }
+}
+
+
+/* Unlink n if it is still empty, merging its key range into its
+ * predecessor. Locks are taken in list order: predecessor first. */
+static void unlink_empty(list *l, node *n) {
+    node *pred = l->head;
+    node *next;
+    while ((next = LOAD(&pred->next)) != NULL && next != n && next->low < n->low)
+        pred = next;
+    if (next != n)
+        return;
+
+    node_lock(pred);
+    if (pred->count >= 0 && pred->next == n) {
+        node_lock(n);
+        if (n->count == 0) {
+            n->count = -1;
+            STORE(&pred->next, n->next);
+        }
+        node_unlock(n);
+    }
+    node_unlock(pred);
+}
+
+
+int list_delete(list *l, int val) {
+    while (1) {
+        node *n = locate(l, val);
+        node_lock(n);
+        if (!owns(n, val)) {
+            node_unlock(n);
+            continue;
+        }
+
+        int pos = keys_lower_bound(n->keys, n->count, val);
+        if (pos == n->count || n->keys[pos] != val) {
+            node_unlock(n);
+            return -1;
+        }
+
+        for (int i = pos; i < n->count - 1; i++) {
+            n->keys[i] = n->keys[i + 1];
+        }
+        n->count--;
+        int empty = (n->count == 0 && n != l->head);
+        node_unlock(n);
+
+        if (empty)
+            unlink_empty(l, n);
+        return val;
+    }
+}
+
+
+int list_find(list *l, int val) {
+    while (1) {
+        node *n = locate(l, val);
+        unsigned v = read_begin(n);
+        int count = n->count;
+        int responsible = owns(n, val);
+        int found = 0;
+        if (responsible && count <= NODE_KEYS) {
+            int pos = keys_lower_bound(n->keys, count, val);
+            found = (pos < count && n->keys[pos] == val);
+        }
+        if (read_validate(n, v) && responsible)
+            return found;
+    }
+}
+
+
+/* debuggin API */
+void list_print(list *l, int num_ops) {
+    printf("-> [");
+    for (node *n = l->head; n != NULL; n = n->next) {
+        for (int i = 0; i < n->count; i++) {
+            printf("%d,", n->keys[i]);
+        }
+    }
+    printf("]\n");
+}
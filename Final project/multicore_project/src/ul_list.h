@@ -0,0 +1,37 @@
+#ifndef MULTICORE_UL_LIST_H
+#define MULTICORE_UL_LIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CAS(ptr,old_val,new_val) \
+    (__sync_bool_compare_and_swap(ptr, old_val, new_val))
+
+/* keys per node, chosen so that a node fills one 64-byte cacheline */
+#define NODE_KEYS 11
+
+typedef struct node node;
+typedef struct list list;
+
+/* Unrolled list node. A node holds the sorted keys in [low, next->low).
+ * version is a sequence lock: writers make it odd while they modify the
+ * node, readers retry when it changed under them. */
+struct node {
+    unsigned version;
+    int count;                /* keys in use, -1 once unlinked */
+    int low;                  /* smallest key this node may hold */
+    int keys[NODE_KEYS];
+    node *next;
+} __attribute__((aligned(64)));
+
+struct list {
+    node *head;               /* low = INT_MIN, never unlinked */
+};
+
+list* list_new(list *l);
+int list_insert(list *l, int val);
+int list_delete(list *l, int val);
+int list_find(list *l, int val);
+void list_print(list *l, int num_ops);
+
+#endif //MULTICORE_UL_LIST_H
@@ -0,0 +1,92 @@
+#include "ul_list.h"
+#include "affinity.h"
+#include "pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+#include <getopt.h>
+
+
+int main(int argc, char** argv) {
+    affinity_policy policy = AFFINITY_NONE;
+    int numa_node = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:")) != -1) {
+        switch (opt) {
+        case 'a':
+            if (affinity_parse(optarg, &policy, &numa_node) != 0) {
+                printf("unknown affinity policy: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        default:
+            printf("usage: %s [-a none|compact|scatter|node[:N]] threads ops insert_ratio delete_ratio\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    if ((argc - optind) < 4) {
+        printf("I need four fixed arguments!");
+        exit(1);
+    }
+
+    int num_threads = strtol(argv[optind], NULL, 10);
+    int num_ops = strtol(argv[optind + 1], NULL, 10);
+    float insert_ratio = strtof(argv[optind + 2], NULL);
+    float delete_ratio = strtof(argv[optind + 3], NULL);
+
+    /* mapping from the ratio to range(0, 1) */
+    float insert_ts = insert_ratio;
+    float delete_ts = insert_ts + delete_ratio;
+
+    time_t t;
+    srand((unsigned) time(&t));
+
+    list l;
+    list_new(&l);
+
+    long deleted = 0, found = 0;
+    # pragma omp parallel num_threads(num_threads) reduction(+:deleted, found)
+    {
+    /* pin first, then pre-touch this thread's nodes on its own NUMA node */
+    affinity_pin(policy, numa_node, omp_get_thread_num());
+    pool_reserve(sizeof(node), num_ops / num_threads + 1);
+
+    # pragma omp for
+    for (int i = 0; i < num_ops; i++) {
+        float r = (float) rand() / (float) RAND_MAX;
+        int num  = rand();
+        if (r < insert_ts)  {
+            list_insert(&l, num);
+
+            #ifdef DEBUG
+            printf("inserting %d, index: %d, by %d\n", num, i, omp_get_thread_num());
+            #endif
+        } else if (insert_ts < r && r < delete_ts) {
+            int val = list_delete(&l, num);
+            deleted += (val != -1);
+
+            #ifdef DEBUG
+            printf("deleting %d, index: %d, status: %d, by %d\n", num, i, val, (int) omp_get_thread_num());
+            #endif
+        } else {
+            int val = list_find(&l, num);
+            found += val;
+
+            #ifdef DEBUG
+            printf("finding %d, index: %d, status: %d, by %d\n", num, i, val, (int) omp_get_thread_num());
+            #endif
+        }
+    }
+    }
+
+    #ifdef DEBUG
+    list_print(&l, num_ops);
+    printf("deleted: %ld, found: %ld\n", deleted, found);
+    #endif
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+#!/bin/bash
+# Exhaustive search with the path cost summed at every leaf (-DLEAF_COST)
+# against the prefix cost carried down the recursion.
+# usage: bench_cost.sh [threads]
+threads=${1:-1}
+gcc -O2 -fopenmp -DLEAF_COST -o ptsm_leaf ptsm.c
+gcc -O2 -fopenmp -o ptsm_prefix ptsm.c
+for (( i = 10; i <= 12; ++i ))
+do
+    for bin in ptsm_leaf ptsm_prefix
+    do
+        echo "$bin $i"
+        ./$bin -m exhaustive $i $threads "cities$i.txt" | grep -E "^Distance|parallel part\.$"
+    done
+done
+rm -f ptsm_leaf ptsm_prefix
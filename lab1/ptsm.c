@@ -1,24 +1,71 @@
+/* POSIX as well as C99: posix_memalign, mmap */
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <omp.h>
 #include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
 
 // Global
 int num;
-int **weights;
+/* Distance matrix: one cacheline-aligned block shared read-only by the
+ * threads, each row padded to whole cachelines. Build with -DWEIGHT16 to
+ * store 16-bit weights; the choice is made at compile time, and a build
+ * with WEIGHT16 refuses a matrix whose weights do not fit. */
+#ifdef WEIGHT16
+typedef unsigned short weight_t;
+#define WEIGHT_MAX 65535
+#else
+typedef int weight_t;
+#endif
+weight_t *weights;
+size_t stride;
+#define WEIGHT(i, j) weights[(size_t)(i) * stride + (j)]
 int min_cost = 2147483647;
 int *min_path;
+int *min_out;
+int split_depth = 2;
+// this process and the number of processes, 0 and 1 without MPI
+int rank = 0;
+int ranks = 1;
+
+enum { MODE_BB, MODE_HK, MODE_EXHAUSTIVE, MODE_SIMD, MODE_HEUR, MODE_SA, NUM_MODES };
+const char *mode_names[NUM_MODES] = { "bb", "hk", "exhaustive", "simd", "heur", "sa" };
+
+// tours evaluated at once by the simd engine, one per AVX2 lane
+#define BLOCK_TOURS 8
+int *thread_min_cost;
+int **thread_min_path;
+long *pruned;
 
 void initialize_cost(int *cost){
     if (num == 1)
 	*cost = 0;
     else if(num == 2)
-	*cost = weights[0][1];
+	*cost = WEIGHT(0, 1);
     else
     	*cost = 2147483647;
 }
 
+// aligned_alloc is C11 only
+void *aligned_block(size_t alignment, size_t size){
+    void *block;
+    if (posix_memalign(&block, alignment, size) != 0)
+	return NULL;
+    return block;
+}
+
 int *initialize_min_path(){
     int *path = (int *)malloc(num * sizeof(int));
     memset(path, 0, num * sizeof(int));
@@ -37,7 +84,7 @@ int compute_cost(int *path){
     int cost = 0;
     int i;
     for (i = 0; i < num - 1; ++i)
-	cost += weights[path[i]][path[i+1]];
+	cost += WEIGHT(path[i], path[i+1]);
     return cost;
 }
 
@@ -47,12 +94,25 @@ void swap(int *x, int *y){
     *y = temp;
 }
 
-void permute(int *path, int l, int r, int *min_cost, int *min_path){
+/* cost is the cost of path[0..l-1]: every level adds one edge, so a leaf
+ * costs O(1). Build with -DLEAF_COST to sum the whole path at every leaf
+ * instead, as the original version did. */
+#ifdef LEAF_COST
+#define PREFIX_EDGE(path, l) 0
+#else
+#define PREFIX_EDGE(path, l) WEIGHT((path)[(l)-1], (path)[(l)])
+#endif
+
+void permute(int *path, int l, int r, int cost, int *min_cost, int *min_path){
     int i;
     if (l > r)
 	return;
     else if (l == r){
-	int cost = compute_cost(path);
+#ifdef LEAF_COST
+	cost = compute_cost(path);
+#else
+	cost += PREFIX_EDGE(path, l);
+#endif
 	if (cost < *min_cost){
 	    *min_cost = cost;
 	    memcpy(min_path, path, num * sizeof(int));
@@ -61,122 +121,1512 @@ void permute(int *path, int l, int r, int *min_cost, int *min_path){
     else{
 	for (i = l; i <= r; ++i){
 	    swap(path+l, path+i);
-	    permute(path, l+1, r, min_cost, min_path);
+	    permute(path, l+1, r, cost + PREFIX_EDGE(path, l), min_cost, min_path);
 	    swap(path+l, path+i);
 	}
     }
 }
 
+int symmetric;
+
+int is_symmetric(){
+    int i, j;
+    for (i = 0; i < num; ++i)
+	for (j = 0; j < i; ++j)
+	    if (WEIGHT(i, j) != WEIGHT(j, i))
+		return 0;
+    return 1;
+}
+
+/* Symmetric matrices only: the cheapest and the second cheapest edge of
+ * each city, to any other city. An unplaced city that is not the path's
+ * last has two neighbors on the path, so it pays at least min_two. */
+int *min_two;
+int *second;
+
+/* Cheapest edge leaving each city, edges back to city 0 excluded:
+ * every city on a path but the last one pays at least that much. */
+void initialize_bounds(){
+    min_out = (int *)malloc(num * sizeof(int));
+    int i, j;
+    for (i = 0; i < num; ++i){
+	min_out[i] = -1;
+	for (j = 1; j < num; ++j){
+	    if (j != i && (min_out[i] < 0 || WEIGHT(i, j) < min_out[i]))
+		min_out[i] = WEIGHT(i, j);
+	}
+	if (min_out[i] < 0)
+	    min_out[i] = 0;
+    }
+
+    symmetric = is_symmetric();
+    if (!symmetric)
+	return;
+    min_two = (int *)malloc(num * sizeof(int));
+    second = (int *)malloc(num * sizeof(int));
+    for (i = 0; i < num; ++i){
+	int first = -1;
+	second[i] = -1;
+	for (j = 0; j < num; ++j){
+	    if (j == i)
+		continue;
+	    int w = WEIGHT(i, j);
+	    if (first < 0 || w < first){
+		second[i] = first;
+		first = w;
+	    }
+	    else if (second[i] < 0 || w < second[i])
+		second[i] = w;
+	}
+	if (first < 0)
+	    first = 0;
+	if (second[i] < 0)
+	    second[i] = 0;
+	min_two[i] = first + second[i];
+    }
+}
+
+/* Lower bound on the cost still to pay after path[0..l-1]: one edge out of
+ * path[l-1] and one out of every unplaced city except the path's last.
+ * rest is the sum of min_out over the unplaced cities path[l..num-1].
+ *
+ * On a symmetric matrix every remaining edge is also counted from its
+ * other end: path[l-1] gets one more edge, every unplaced city two but
+ * the last one, so twice the cost is at least min_out[path[l-1]] plus
+ * min_two over the unplaced cities, less the largest second. The larger
+ * bound of the two is returned. */
+int lower_bound(int *path, int l, int rest){
+    int i, max = 0;
+    for (i = l; i < num; ++i)
+	if (min_out[path[i]] > max)
+	    max = min_out[path[i]];
+    int bound = min_out[path[l-1]] + rest - max;
+    if (symmetric){
+	int two = 0, max_second = 0;
+	for (i = l; i < num; ++i){
+	    two += min_two[path[i]];
+	    if (second[path[i]] > max_second)
+		max_second = second[path[i]];
+	}
+	int degree_bound = (min_out[path[l-1]] + two - max_second + 1) / 2;
+	if (degree_bound > bound)
+	    bound = degree_bound;
+    }
+    return bound;
+}
+
+/* The global incumbent: read without a lock while searching,
+ * lowered with a CAS so that every thread prunes against it. */
+int incumbent(){
+    return __atomic_load_n(&min_cost, __ATOMIC_RELAXED);
+}
+
+/* Returns 1 if cost became the new incumbent. */
+int update_incumbent(int cost){
+    int current = incumbent();
+    while (cost < current){
+	if (__atomic_compare_exchange_n(&min_cost, &current, cost, 0,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	    return 1;
+    }
+    return 0;
+}
+
+/* Extend path[0..l-1], whose cost is cost, with every ordering of the
+ * remaining cities, skipping subtrees that cannot beat the incumbent.
+ * The thread's own best path is kept in local_min_cost / local_min_path,
+ * skipped subtrees are counted in *pruned. */
+void branch_bound(int *path, int l, int cost, int rest, int *local_min_cost, int *local_min_path, long *pruned){
+    int i;
+    if (l == num){
+	if (update_incumbent(cost)){
+	    *local_min_cost = cost;
+	    memcpy(local_min_path, path, num * sizeof(int));
+	}
+	return;
+    }
+    if (cost + lower_bound(path, l, rest) >= incumbent()){
+	++*pruned;
+	return;
+    }
+    int last = path[l-1];
+    for (i = l; i < num; ++i){
+	swap(path+l, path+i);
+	int next_cost = cost + WEIGHT(last, path[l]);
+	if (next_cost < incumbent())
+	    branch_bound(path, l+1, next_cost, rest - min_out[path[l]], local_min_cost, local_min_path, pruned);
+	else
+	    ++*pruned;
+	swap(path+l, path+i);
+    }
+}
+
+/* Spawn a task per prefix until split_depth cities follow city 0; the
+ * rest of each subtree is searched sequentially by its task. Results go
+ * to the slots of the thread running the task. */
+void search_tasks(int *path, int l, int cost, int rest){
+    int i, t = omp_get_thread_num();
+    if (l > split_depth || l == num){
+	long local_pruned = 0;
+	branch_bound(path, l, cost, rest, &thread_min_cost[t], thread_min_path[t], &local_pruned);
+	pruned[t] += local_pruned;
+	return;
+    }
+    if (cost + lower_bound(path, l, rest) >= incumbent()){
+	++pruned[t];
+	return;
+    }
+    int last = path[l-1];
+    for (i = l; i < num; ++i){
+	int next_cost = cost + WEIGHT(last, path[i]);
+	if (next_cost >= incumbent()){
+	    ++pruned[t];
+	    continue;
+	}
+	int *child = (int *)malloc(num * sizeof(int));
+	memcpy(child, path, num * sizeof(int));
+	swap(child+l, child+i);
+	#pragma omp task firstprivate(child, next_cost)
+	{
+	search_tasks(child, l+1, next_cost, rest - min_out[child[l]]);
+	free(child);
+	}
+    }
+}
+
+/* min_cost already holds the best cost: the thread that found it,
+ * i.e. the last one to lower the incumbent, supplies the path. */
 void update_global(int local_min_cost, int *local_min_path){
     #pragma omp critical
     {
-        if (local_min_cost < min_cost){
-	    min_cost = local_min_cost;
+        if (local_min_cost == min_cost)
 	    memcpy(min_path, local_min_path, num * sizeof(int));
+    }
+}
+
+// Per-thread results, written by the tasks a thread runs
+void initialize_thread_results(int num_of_threads){
+    int i;
+    thread_min_cost = (int *)malloc(num_of_threads * sizeof(int));
+    thread_min_path = (int **)malloc(num_of_threads * sizeof(int*));
+    pruned = (long *)calloc(num_of_threads, sizeof(long));
+    for (i = 0; i < num_of_threads; ++i){
+	thread_min_cost[i] = 2147483647;
+	thread_min_path[i] = initialize_min_path();
+    }
+}
+void free_thread_results(int num_of_threads){
+    int i;
+    for (i = 0; i < num_of_threads; ++i)
+	free(thread_min_path[i]);
+    free(thread_min_path);
+    free(thread_min_cost);
+}
+/* Branch and bound over all paths, split into tasks by search_tasks. */
+void solve_branch_bound(int num_of_threads){
+    int i, rest = 0;
+    for (i = 1; i < num; ++i)
+	rest += min_out[i];
+
+    initialize_thread_results(num_of_threads);
+    int *root = initialize_path();
+
+    #pragma omp parallel num_threads(num_of_threads)
+    {
+    #pragma omp single
+    {
+    if (num > 1)
+	search_tasks(root, 1, 0, rest);
+    }
+
+    int t = omp_get_thread_num();
+    update_global(thread_min_cost[t], thread_min_path[t]);
+    }
+
+    free_thread_results(num_of_threads);
+    free(root);
+}
+
+/* The frontier: the prefixes of depth cities after city 0, numbered in
+ * mixed radix, the digit at level l picking one of the num - l cities
+ * left. MPI hands them out, checkpoints record which ones are done. */
+long num_prefixes(int depth){
+    long count = 1;
+    int l;
+    for (l = 1; l <= depth; ++l)
+	count *= num - l;
+    return count;
+}
+
+/* Places prefix number index in path[1..depth] with the swaps search_tasks
+ * would make, takes its cities out of *rest and returns its cost. */
+int decode_prefix(long index, int depth, int *path, int *rest){
+    int l, cost = 0;
+    for (l = 1; l <= depth; ++l){
+	swap(path+l, path+l+index%(num-l));
+	index /= num - l;
+	cost += WEIGHT(path[l-1], path[l]);
+	*rest -= min_out[path[l]];
+    }
+    return cost;
+}
+
+#ifdef USE_MPI
+/* Branch and bound across MPI ranks, for builds with -DUSE_MPI started by
+ * mpirun with two ranks or more. Rank 0 coordinates: it hands out the
+ * prefixes of split_depth cities after city 0, one per request, so that
+ * faster workers take more of them. Every other rank is a worker that
+ * splits each prefix into OpenMP tasks MPI_TASK_LEVELS cities deeper.
+ * Between prefixes the workers share their bound through a non-blocking
+ * allreduce of {bound, done}. They keep starting rounds until one shows
+ * every worker done. A MINLOC reduction then finds the rank holding the
+ * best path, and that rank broadcasts it. */
+#define TAG_WORK 1
+#define MPI_TASK_LEVELS 2
+
+void coordinate(long prefixes, int workers){
+    long next = 0, none = -1;
+    MPI_Status status;
+    while (workers > 0){
+	MPI_Recv(NULL, 0, MPI_INT, MPI_ANY_SOURCE, TAG_WORK, MPI_COMM_WORLD, &status);
+	if (next < prefixes){
+	    MPI_Send(&next, 1, MPI_LONG, status.MPI_SOURCE, TAG_WORK, MPI_COMM_WORLD);
+	    ++next;
+	}
+	else {
+	    MPI_Send(&none, 1, MPI_LONG, status.MPI_SOURCE, TAG_WORK, MPI_COMM_WORLD);
+	    --workers;
 	}
     }
 }
 
-int main(int argc, char *argv[]){
+// MPI calls come from the master thread only, the others run the tasks
+void work(int depth, int rest, int num_of_threads, MPI_Comm workers){
+    int share[2] = { incumbent(), 0 }, shared[2];
+    MPI_Request round;
+    MPI_Iallreduce(share, shared, 2, MPI_INT, MPI_MIN, workers, &round);
+    int *path = initialize_path();
+
+    #pragma omp parallel num_threads(num_of_threads)
+    {
+    #pragma omp master
+    {
+    long index;
+    int i, finished;
+    while (1){
+	MPI_Send(NULL, 0, MPI_INT, 0, TAG_WORK, MPI_COMM_WORLD);
+	MPI_Recv(&index, 1, MPI_LONG, 0, TAG_WORK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	if (index < 0)
+	    break;
+	for (i = 0; i < num; ++i)
+	    path[i] = i;
+	int prefix_rest = rest;
+	int cost = decode_prefix(index, depth, path, &prefix_rest);
+	#pragma omp taskgroup
+	{
+	search_tasks(path, depth + 1, cost, prefix_rest);
+	}
+
+	MPI_Test(&round, &finished, MPI_STATUS_IGNORE);
+	if (finished){
+	    update_incumbent(shared[0]);
+	    share[0] = incumbent();
+	    MPI_Iallreduce(share, shared, 2, MPI_INT, MPI_MIN, workers, &round);
+	}
+    }
+    }
+    }
+
+    /* Keep sharing the bound until every worker is done. The pending round
+     * still owns share, so it completes before done is set. */
+    MPI_Wait(&round, MPI_STATUS_IGNORE);
+    update_incumbent(shared[0]);
+    share[1] = 1;
+    do {
+	share[0] = incumbent();
+	MPI_Iallreduce(share, shared, 2, MPI_INT, MPI_MIN, workers, &round);
+	MPI_Wait(&round, MPI_STATUS_IGNORE);
+	update_incumbent(shared[0]);
+    } while (shared[1] != 1);
+    free(path);
+}
+
+void solve_mpi(int num_of_threads){
+    int i, t, rest = 0;
+    for (i = 1; i < num; ++i)
+	rest += min_out[i];
+    int depth = split_depth < num - 1 ? split_depth : num - 1;
+
+    initialize_thread_results(num_of_threads);
+    MPI_Comm workers;
+    MPI_Comm_split(MPI_COMM_WORLD, rank == 0 ? MPI_UNDEFINED : 1, rank, &workers);
+    if (rank == 0)
+	coordinate(num_prefixes(depth), ranks - 1);
+    else {
+	split_depth = depth + MPI_TASK_LEVELS;
+	work(depth, rest, num_of_threads, workers);
+	MPI_Comm_free(&workers);
+    }
+
+    struct { int cost; int rank; } best = { 2147483647, rank }, winner;
+    int best_thread = 0;
+    for (t = 0; t < num_of_threads; ++t){
+	if (thread_min_cost[t] < best.cost){
+	    best.cost = thread_min_cost[t];
+	    best_thread = t;
+	}
+    }
+    MPI_Allreduce(&best, &winner, 1, MPI_2INT, MPI_MINLOC, MPI_COMM_WORLD);
+    // nothing found when num < 3: min_cost and min_path are preset
+    if (winner.cost < 2147483647){
+	if (rank == winner.rank)
+	    memcpy(min_path, thread_min_path[best_thread], num * sizeof(int));
+	MPI_Bcast(min_path, num, MPI_INT, winner.rank, MPI_COMM_WORLD);
+	min_cost = winner.cost;
+    }
+    // pruned counts of thread i summed over the workers
+    MPI_Reduce(rank == 0 ? MPI_IN_PLACE : pruned, pruned, num_of_threads, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    free_thread_results(num_of_threads);
+}
+#endif
+
+/* Checkpoints of the bb and exhaustive modes. The file holds a header,
+ * the best path so far, then one done bit per frontier prefix. It is
+ * written to a temporary file renamed over the last checkpoint, so a
+ * crash while saving leaves the previous one intact. */
+#define CHECKPOINT_MAGIC "TSMK"
+char *checkpoint_file;
+double checkpoint_interval = 60.0;
+int resume;
+
+struct checkpoint {
+    char magic[4];
+    int num;
+    int depth;
+    int mode;
+    unsigned hash;       // of the weights, so a different matrix is refused
+    int cost;
+    long prefixes;
+};
+
+unsigned weights_hash(){
+    unsigned hash = 2166136261u;
+    int i, j;
+    for (i = 0; i < num; ++i)
+	for (j = 0; j < num; ++j)
+	    hash = (hash ^ (unsigned)WEIGHT(i, j)) * 16777619u;
+    return hash;
+}
+
+int is_done(unsigned char *done, long p){
+    return __atomic_load_n(&done[p / 8], __ATOMIC_RELAXED) & (1 << p % 8);
+}
+
+void save_checkpoint(int mode, int depth, long prefixes, int cost, unsigned char *done){
+    struct checkpoint header = { CHECKPOINT_MAGIC, num, depth, mode, weights_hash(), cost, prefixes };
+    char *tmp = (char *)malloc(strlen(checkpoint_file) + 5);
+    sprintf(tmp, "%s.tmp", checkpoint_file);
+    FILE *fp = fopen(tmp, "wb");
+    int ok = fp != NULL;
+    if (ok){
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(min_path, sizeof(int), num, fp);
+	fwrite(done, 1, (prefixes + 7) / 8, fp);
+	ok = fclose(fp) == 0 && rename(tmp, checkpoint_file) == 0;
+    }
+    if (!ok)
+	printf("Cannot write checkpoint %s!\n", checkpoint_file);
+    free(tmp);
+}
+
+/* Restores min_cost, min_path and the done bits. Returns 0, or the exit
+ * code after printing why the checkpoint was refused. */
+int load_checkpoint(int mode, int depth, long prefixes, unsigned char *done){
+    FILE *fp = fopen(checkpoint_file, "rb");
+    if (!fp){
+	printf("Checkpoint %s cannot be opened!\n", checkpoint_file);
+	return 2;
+    }
+    struct checkpoint header;
+    int *path = initialize_min_path();
+    int ok = fread(&header, sizeof(header), 1, fp) == 1
+	&& memcmp(header.magic, CHECKPOINT_MAGIC, 4) == 0
+	&& header.num == num && header.depth == depth && header.mode == mode
+	&& header.prefixes == prefixes && header.hash == weights_hash()
+	&& fread(path, sizeof(int), num, fp) == (size_t)num
+	&& fread(done, 1, (prefixes + 7) / 8, fp) == (size_t)(prefixes + 7) / 8;
+    fclose(fp);
+    if (!ok){
+	printf("Checkpoint %s does not match this run!\n", checkpoint_file);
+	free(path);
+	return 5;
+    }
+    if (header.cost < min_cost){
+	min_cost = header.cost;
+	memcpy(min_path, path, num * sizeof(int));
+    }
+    free(path);
+
+    long p, searched = 0;
+    for (p = 0; p < prefixes; ++p)
+	if (is_done(done, p))
+	    ++searched;
+    printf("Resumed from %s: %ld of %ld prefixes searched, distance %d\n", checkpoint_file, searched, prefixes, min_cost);
+    return 0;
+}
+
+/* Branch and bound or exhaustive search, one frontier prefix at a time,
+ * for runs with a checkpoint file. A prefix is marked done only once its
+ * best path is merged into min_path, and the checkpoint is saved under
+ * the same lock, so a saved checkpoint never misses a result. */
+int solve_frontier(int mode, int num_of_threads){
+    int i, rest = 0;
+    for (i = 1; i < num; ++i)
+	rest += min_out[i];
+    // the last city of a path is never a prefix of its own
+    int depth = split_depth < num - 2 ? split_depth : num - 2;
+    if (depth < 0)
+	depth = 0;
+    long p, prefixes = num_prefixes(depth);
+    unsigned char *done = (unsigned char *)calloc((prefixes + 7) / 8, 1);
+    pruned = (long *)calloc(num_of_threads, sizeof(long));
+
+    if (resume){
+	int res = load_checkpoint(mode, depth, prefixes, done);
+	if (res != 0){
+	    free(done);
+	    return res;
+	}
+    }
+    // min_cost is the bound the search lowers, best_cost the cost of min_path
+    int best_cost = min_cost;
+    double last_save = omp_get_wtime();
+
+    #pragma omp parallel num_threads(num_of_threads)
+    {
+    int t = omp_get_thread_num();
+    int *path = initialize_path();
+    int *local_min_path = initialize_min_path();
+
+    #pragma omp for schedule(dynamic)
+    for (p = 0; p < prefixes; ++p){
+	if (is_done(done, p))
+	    continue;
+	int prefix_rest = rest;
+	for (i = 0; i < num; ++i)
+	    path[i] = i;
+	int cost = decode_prefix(p, depth, path, &prefix_rest);
+	int local_min_cost = 2147483647;
+	if (mode == MODE_EXHAUSTIVE){
+	    // the incumbent only seeds the threshold: its path may not be merged yet
+	    int seed = incumbent();
+	    local_min_cost = seed;
+	    permute(path, depth+1, num-1, cost, &local_min_cost, local_min_path);
+	    if (local_min_cost < seed)
+		update_incumbent(local_min_cost);
+	    else
+		local_min_cost = 2147483647;
+	}
+	else
+	    branch_bound(path, depth+1, cost, prefix_rest, &local_min_cost, local_min_path, &pruned[t]);
+
+	#pragma omp critical(checkpoint)
+	{
+	if (local_min_cost < best_cost){
+	    best_cost = local_min_cost;
+	    memcpy(min_path, local_min_path, num * sizeof(int));
+	}
+	__atomic_fetch_or(&done[p / 8], 1 << p % 8, __ATOMIC_RELAXED);
+	if (omp_get_wtime() - last_save >= checkpoint_interval){
+	    save_checkpoint(mode, depth, prefixes, best_cost, done);
+	    last_save = omp_get_wtime();
+	}
+	}
+    }
+    free(path);
+    free(local_min_path);
+    }
+
+    // a finished run leaves a checkpoint with every prefix done
+    min_cost = best_cost;
+    save_checkpoint(mode, depth, prefixes, best_cost, done);
+    free(done);
+    return 0;
+}
+
+/* Every ordering, without pruning: the original search, distributed by
+ * setting the second city to visit. */
+void solve_exhaustive(int num_of_threads){
+    int i, j;
+    int local_min_cost;
+    int *local_min_path;
+    int *local_path;
+
+    #pragma omp parallel private(i, j, local_min_cost, local_min_path, local_path) num_threads(num_of_threads)
+    {
+    local_min_cost = 2147483647;
+    local_min_path = initialize_min_path();
+    local_path = initialize_path();
+
+    #pragma omp for schedule(dynamic)
+    for (i = 1; i < num; ++i){
+	local_path[1] = i;
+	for (j = 1; j < i; ++j)
+	    local_path[1+j] = j;
+        for (j = i+1; j < num; ++j)
+	    local_path[j] = j;
+	permute(local_path, 2, num-1, PREFIX_EDGE(local_path, 1), &local_min_cost, local_min_path);
+    }
+
+    update_incumbent(local_min_cost);
+    #pragma omp barrier
+    update_global(local_min_cost, local_min_path);
+    free(local_min_path);
+    free(local_path);
+    }
+}
+
+/* Costs of the BLOCK_TOURS tours of a block, which is stored position
+ * by position: block[p * BLOCK_TOURS + t] is the p-th city of tour t. */
+void block_costs_scalar(const int *block, int *costs){
+    int p, t;
+    for (t = 0; t < BLOCK_TOURS; ++t)
+	costs[t] = 0;
+    for (p = 1; p < num; ++p){
+	const int *from = block + (p-1) * BLOCK_TOURS;
+	const int *to = block + p * BLOCK_TOURS;
+	for (t = 0; t < BLOCK_TOURS; ++t)
+	    costs[t] += WEIGHT(from[t], to[t]);
+    }
+}
+
+#if defined(__x86_64__) && !defined(WEIGHT16)
+/* The same with one gather per path position for all eight tours. */
+__attribute__((target("avx2")))
+void block_costs_avx2(const int *block, int *costs){
+    __m256i sum = _mm256_setzero_si256();
+    __m256i row = _mm256_set1_epi32(stride);
+    __m256i from = _mm256_load_si256((const __m256i *)block);
+    int p;
+    for (p = 1; p < num; ++p){
+	__m256i to = _mm256_load_si256((const __m256i *)(block + p * BLOCK_TOURS));
+	__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(from, row), to);
+	sum = _mm256_add_epi32(sum, _mm256_i32gather_epi32(weights, index, 4));
+	from = to;
+    }
+    _mm256_storeu_si256((__m256i *)costs, sum);
+}
+#endif
+
+/* Every ordering, enumerated without recursion by Heap's algorithm (one
+ * swap per permutation) and evaluated BLOCK_TOURS tours at a time, with
+ * AVX2 gathers when the cpu has them. Threads split on the second city. */
+void solve_simd(int num_of_threads){
+    void (*block_costs)(const int *, int *) = block_costs_scalar;
+#if defined(__x86_64__) && !defined(WEIGHT16)
+    if (__builtin_cpu_supports("avx2"))
+	block_costs = block_costs_avx2;
+#endif
+    int k = num - 2;
+    if (k < 1)
+	return;
+
+    #pragma omp parallel num_threads(num_of_threads)
+    {
+    int local_min_cost = 2147483647;
+    int *local_min_path = initialize_min_path();
+    int *block = (int *)aligned_block(32, num * BLOCK_TOURS * sizeof(int));
+    int *rest = (int *)malloc(k * sizeof(int));
+    int *c = (int *)malloc(k * sizeof(int));
+    int costs[BLOCK_TOURS];
+    int i, j, p, t, filled;
+    memset(block, 0, num * BLOCK_TOURS * sizeof(int));
+
+    #pragma omp for schedule(dynamic)
+    for (i = 1; i < num; ++i){
+	for (j = 1, p = 0; j < num; ++j)
+	    if (j != i)
+		rest[p++] = j;
+	memset(c, 0, k * sizeof(int));
+	filled = 0;
+	j = 0;
+	while (1){
+	    // emit the current ordering into the next lane
+	    block[filled] = 0;
+	    block[BLOCK_TOURS + filled] = i;
+	    for (p = 0; p < k; ++p)
+		block[(p + 2) * BLOCK_TOURS + filled] = rest[p];
+	    ++filled;
+
+	    // Heap's algorithm: advance to the next ordering
+	    int done = 0;
+	    while (j < k && c[j] >= j){
+		c[j] = 0;
+		++j;
+	    }
+	    if (j >= k)
+		done = 1;
+	    else{
+		if (j % 2 == 0)
+		    swap(rest, rest + j);
+		else
+		    swap(rest + c[j], rest + j);
+		++c[j];
+		j = 0;
+	    }
+
+	    if (filled == BLOCK_TOURS || done){
+		block_costs(block, costs);
+		for (t = 0; t < filled; ++t){
+		    if (costs[t] < local_min_cost){
+			local_min_cost = costs[t];
+			for (p = 0; p < num; ++p)
+			    local_min_path[p] = block[p * BLOCK_TOURS + t];
+		    }
+		}
+		filled = 0;
+	    }
+	    if (done)
+		break;
+	}
+    }
+
+    update_incumbent(local_min_cost);
+    #pragma omp barrier
+    update_global(local_min_cost, local_min_path);
+    free(local_min_path);
+    free(block);
+    free(rest);
+    free(c);
+    }
+}
+
+/* Held-Karp dynamic programming. cost[mask*m + j] is the cheapest path
+ * from city 0 through the cities in mask (bit k is city k+1) that ends in
+ * city j+1. A mask only reads masks with one city less, so the masks are
+ * ordered by popcount and every layer is computed in parallel.
+ * O(n^2 2^n) time and O(n 2^n) memory; returns -1 if that is too much.
+ * Masks are ints, and HK_MAX_CITIES keeps the table within a few GB. */
+#define HK_MAX_CITIES 26
+
+int held_karp(int num_of_threads){
+    int m = num - 1;
+    if (m < 1)
+	return 0;
+    if (num > HK_MAX_CITIES)
+	return -1;
+    size_t full = (size_t)1 << m;
+    int *cost = (int *)malloc(full * m * sizeof(int));
+    int *order = (int *)malloc(full * sizeof(int));
+    size_t *layer = (size_t *)calloc(m + 2, sizeof(size_t));
+    if (!cost || !order || !layer){
+	free(cost);
+	free(order);
+	free(layer);
+	return -1;
+    }
+
+    // counting sort of the masks by popcount
+    size_t x;
+    int s;
+    for (x = 0; x < full; ++x)
+	++layer[__builtin_popcount(x) + 1];
+    for (s = 1; s <= m + 1; ++s)
+	layer[s] += layer[s-1];
+    size_t *fill = (size_t *)malloc((m + 1) * sizeof(size_t));
+    memcpy(fill, layer, (m + 1) * sizeof(size_t));
+    for (x = 0; x < full; ++x)
+	order[fill[__builtin_popcount(x)]++] = x;
+    free(fill);
+
+    #pragma omp parallel private(s) num_threads(num_of_threads)
+    for (s = 1; s <= m; ++s){
+	size_t y;
+	#pragma omp for schedule(static)
+	for (y = layer[s]; y < layer[s+1]; ++y){
+	    int mask = order[y];
+	    int *row = cost + (size_t)mask * m;
+	    int j, k;
+	    for (j = 0; j < m; ++j){
+		if (!(mask & (1 << j)))
+		    continue;
+		int prev = mask ^ (1 << j);
+		if (prev == 0){
+		    row[j] = WEIGHT(0, j+1);
+		    continue;
+		}
+		int *prev_row = cost + (size_t)prev * m;
+		int best = 2147483647;
+		for (k = 0; k < m; ++k){
+		    if ((prev & (1 << k)) && prev_row[k] + WEIGHT(k+1, j+1) < best)
+			best = prev_row[k] + WEIGHT(k+1, j+1);
+		}
+		row[j] = best;
+	    }
+	}
+    }
+
+    // walk the table back from the cheapest end city
+    int mask = full - 1, j, k, pos;
+    int *row = cost + (size_t)mask * m;
+    int end = 0;
+    for (j = 1; j < m; ++j)
+	if (row[j] < row[end])
+	    end = j;
+    min_cost = row[end];
+    min_path[0] = 0;
+    for (pos = num - 1; pos > 0; --pos){
+	min_path[pos] = end + 1;
+	int prev = mask ^ (1 << end);
+	if (prev == 0)
+	    break;
+	int target = cost[(size_t)mask * m + end];
+	for (k = 0; k < m; ++k){
+	    if ((prev & (1 << k)) && cost[(size_t)prev * m + k] + WEIGHT(k+1, end+1) == target)
+		break;
+	}
+	mask = prev;
+	end = k;
+    }
+
+    free(cost);
+    free(order);
+    free(layer);
+    return 0;
+}
+
+/* Heuristic mode: nearest neighbor construction, then local search with
+ * 2-opt (symmetric matrices only, since it reverses a stretch of the path)
+ * and Or-opt (move a run of up to OR_OPT_MAX cities elsewhere, keeping its
+ * direction). Candidate moves only create edges to the NEIGHBORS nearest
+ * cities, so a pass costs O(n * NEIGHBORS). */
+#define NEIGHBORS 8
+#define OR_OPT_MAX 3
+
+enum { MOVE_NONE, MOVE_2OPT, MOVE_OR_OPT };
+
+typedef struct move {
+    int delta;
+    int kind;
+    int i, j, k;        // 2-opt: reverse path[i..j]; Or-opt: path[i..j] after path[k]
+} move;
+
+int *neighbors;
+int num_neighbors;
+
+/* The num_neighbors closest cities of every city, by the weight of the
+ * edges in both directions. */
+void initialize_neighbors(){
+    int a, b, n, pos;
+    num_neighbors = (num - 1 < NEIGHBORS) ? num - 1 : NEIGHBORS;
+    neighbors = (int *)malloc(num * NEIGHBORS * sizeof(int));
+    for (a = 0; a < num; ++a){
+	int *list = neighbors + a * NEIGHBORS;
+	n = 0;
+	for (b = 0; b < num; ++b){
+	    if (b == a)
+		continue;
+	    int d = WEIGHT(a, b) + WEIGHT(b, a);
+	    // insertion into the sorted list, dropping the farthest
+	    for (pos = n; pos > 0 && WEIGHT(a, list[pos-1]) + WEIGHT(list[pos-1], a) > d; --pos)
+		if (pos < num_neighbors)
+		    list[pos] = list[pos-1];
+	    if (pos < num_neighbors){
+		list[pos] = b;
+		if (n < num_neighbors)
+		    ++n;
+	    }
+	}
+    }
+}
+
+void nearest_neighbor(int *path){
+    int *visited = (int *)calloc(num, sizeof(int));
+    int i, j;
+    path[0] = 0;
+    visited[0] = 1;
+    for (i = 1; i < num; ++i){
+	int last = path[i-1], best = -1;
+	for (j = 1; j < num; ++j)
+	    if (!visited[j] && (best < 0 || WEIGHT(last, j) < WEIGHT(last, best)))
+		best = j;
+	path[i] = best;
+	visited[best] = 1;
+    }
+    free(visited);
+}
+
+/* Smaller delta first, ties broken by position so the result does not
+ * depend on the number of threads. */
+int better_move(move *a, move *b){
+    if (a->delta != b->delta)
+	return a->delta < b->delta;
+    if (a->kind != b->kind)
+	return a->kind < b->kind;
+    if (a->i != b->i)
+	return a->i < b->i;
+    if (a->j != b->j)
+	return a->j < b->j;
+    return a->k < b->k;
+}
+
+/* Cost change of reversing path[i..j], 0 < i < j; symmetric only. */
+int two_opt_delta(int *path, int i, int j){
+    int delta = WEIGHT(path[i-1], path[j]) - WEIGHT(path[i-1], path[i]);
+    if (j < num - 1)
+	delta += WEIGHT(path[i], path[j+1]) - WEIGHT(path[j], path[j+1]);
+    return delta;
+}
+
+/* Cost change of moving path[i..e] after path[k], k outside [i-1, e]. */
+int or_opt_delta(int *path, int i, int e, int k){
+    int delta = WEIGHT(path[k], path[i]) - WEIGHT(path[i-1], path[i]);
+    if (e + 1 < num)
+	delta += WEIGHT(path[i-1], path[e+1]) - WEIGHT(path[e], path[e+1]);
+    if (k + 1 < num)
+	delta += WEIGHT(path[e], path[k+1]) - WEIGHT(path[k], path[k+1]);
+    return delta;
+}
+
+/* Best improving move that starts at position i. */
+void scan_moves(int *path, int *pos, int i, move *best){
+    int n, len;
+    int prev = path[i-1];
+
+    if (symmetric && i < num - 1){
+	// new edge prev -> c, then the same move seen from path[i] -> c
+	for (n = 0; n < num_neighbors; ++n){
+	    int j = pos[neighbors[prev * NEIGHBORS + n]];
+	    if (j <= i)
+		continue;
+	    move m = { two_opt_delta(path, i, j), MOVE_2OPT, i, j, 0 };
+	    if (better_move(&m, best))
+		*best = m;
+	}
+	for (n = 0; n < num_neighbors; ++n){
+	    int j = pos[neighbors[path[i] * NEIGHBORS + n]] - 1;
+	    if (j <= i)
+		continue;
+	    move m = { two_opt_delta(path, i, j), MOVE_2OPT, i, j, 0 };
+	    if (better_move(&m, best))
+		*best = m;
+	}
+    }
+
+    for (len = 1; len <= OR_OPT_MAX && i + len - 1 < num; ++len){
+	int e = i + len - 1;
+	for (n = 0; n < num_neighbors; ++n){
+	    int k = pos[neighbors[path[i] * NEIGHBORS + n]];
+	    if (k >= i - 1 && k <= e)
+		continue;
+	    move m = { or_opt_delta(path, i, e, k), MOVE_OR_OPT, i, e, k };
+	    if (better_move(&m, best))
+		*best = m;
+	}
+    }
+}
+
+void apply_move(int *path, int *pos, int *tmp, move *m){
+    int p, n = 0;
+    if (m->kind == MOVE_2OPT){
+	int i = m->i, j = m->j;
+	while (i < j){
+	    swap(path + i, path + j);
+	    ++i;
+	    --j;
+	}
+    }
+    else{
+	int i = m->i, e = m->j, k = m->k;
+	if (k < i){
+	    for (p = 0; p <= k; ++p) tmp[n++] = path[p];
+	    for (p = i; p <= e; ++p) tmp[n++] = path[p];
+	    for (p = k + 1; p < i; ++p) tmp[n++] = path[p];
+	    for (p = e + 1; p < num; ++p) tmp[n++] = path[p];
+	}
+	else{
+	    for (p = 0; p < i; ++p) tmp[n++] = path[p];
+	    for (p = e + 1; p <= k; ++p) tmp[n++] = path[p];
+	    for (p = i; p <= e; ++p) tmp[n++] = path[p];
+	    for (p = k + 1; p < num; ++p) tmp[n++] = path[p];
+	}
+	memcpy(path, tmp, num * sizeof(int));
+    }
+    if (pos != NULL)
+	for (p = 0; p < num; ++p)
+	    pos[path[p]] = p;
+}
+
+/* Best-improvement local search: the threads scan the start positions in
+ * parallel, the best move found is applied, until no move improves. */
+int local_search(int *path, int num_of_threads){
+    int *pos = (int *)malloc(num * sizeof(int));
+    int *tmp = (int *)malloc(num * sizeof(int));
+    int p, moves = 0, stop = 0;
+    move best = { 0, MOVE_NONE, 0, 0, 0 };
+    for (p = 0; p < num; ++p)
+	pos[path[p]] = p;
+
+    #pragma omp parallel private(p) num_threads(num_of_threads)
+    while (1){
+	move local = { 0, MOVE_NONE, 0, 0, 0 };
+	#pragma omp for schedule(static)
+	for (p = 1; p < num; ++p)
+	    scan_moves(path, pos, p, &local);
+	#pragma omp critical
+	{
+	if (better_move(&local, &best))
+	    best = local;
+	}
+	#pragma omp barrier
+	#pragma omp single
+	{
+	if (best.kind == MOVE_NONE)
+	    stop = 1;
+	else{
+	    apply_move(path, pos, tmp, &best);
+	    ++moves;
+	}
+	best.delta = 0;
+	best.kind = MOVE_NONE;
+	}
+	if (stop)
+	    break;
+    }
+
+    free(pos);
+    free(tmp);
+    return moves;
+}
+
+void solve_heuristic(int num_of_threads){
+    initialize_neighbors();
+    nearest_neighbor(min_path);
+    if (num > 1){
+	printf("Nearest neighbor distance: %d\n", compute_cost(min_path));
+	int moves = local_search(min_path, num_of_threads);
+	printf("Local search: %d moves (%s)\n", moves, symmetric ? "2-opt and Or-opt" : "Or-opt, asymmetric matrix");
+    }
+    min_cost = compute_cost(min_path);
+    free(neighbors);
+}
+
+/* Simulated annealing: every thread runs its own chain of random 2-opt
+ * (symmetric matrices) and Or-opt moves, starting from the path of the
+ * heuristic mode, for time_budget seconds. The temperature falls geometrically from the
+ * mean uphill move to a thousandth of it. Chains publish their best cost
+ * to the shared incumbent, and every improvement of the incumbent is
+ * printed with its time as a quality-vs-time curve. */
+double time_budget = 1.0;
+
+// moves between two reads of the clock
+#define SA_CHECK 1024
+#define SA_SAMPLES 1000
+// ln(1000): the temperature falls by that factor over the budget
+#define SA_COOLING 6.907755
+
+unsigned next_rand(unsigned *state){
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/* exp(-x) for x >= 0, without libm: Taylor series on x / 32, squared
+ * five times. Plenty for acceptance probabilities. */
+double neg_exp(double x){
+    if (x > 40)
+	return 0;
+    double y = x / 32, term = 1, sum = 1;
+    int n;
+    for (n = 1; n <= 8; ++n){
+	term *= -y / n;
+	sum += term;
+    }
+    for (n = 0; n < 5; ++n)
+	sum *= sum;
+    return sum;
+}
+
+/* A random move that creates an edge to one of the neighbors of the
+ * moved city, as in the local search. */
+void random_move(int *path, int *pos, unsigned *seed, move *m){
+    int c = neighbors[path[0] * NEIGHBORS];
+    if (symmetric && next_rand(seed) % 2){
+	int i = 1 + next_rand(seed) % (num - 2);
+	c = neighbors[path[i-1] * NEIGHBORS + next_rand(seed) % num_neighbors];
+	int j = pos[c];
+	if (j > i){
+	    m->kind = MOVE_2OPT;
+	    m->i = i;
+	    m->j = j;
+	    m->delta = two_opt_delta(path, i, j);
+	    return;
+	}
+    }
+    int len = 1 + next_rand(seed) % OR_OPT_MAX;
+    int i = 1 + next_rand(seed) % (num - len);
+    int e = i + len - 1;
+    int k;
+    do {
+	c = neighbors[path[i] * NEIGHBORS + next_rand(seed) % num_neighbors];
+	k = pos[c];
+    } while (k >= i - 1 && k <= e);
+    m->kind = MOVE_OR_OPT;
+    m->i = i;
+    m->j = e;
+    m->k = k;
+    m->delta = or_opt_delta(path, i, e, k);
+}
+
+void solve_annealing(int num_of_threads){
+    // too few cities for the moves: search them all
+    if (num < OR_OPT_MAX + 3){
+	solve_exhaustive(num_of_threads);
+	return;
+    }
+    initialize_neighbors();
+    int *start = initialize_min_path();
+    nearest_neighbor(start);
+    local_search(start, num_of_threads);
+    int reported = compute_cost(start);
+    double start_time = omp_get_wtime();
+    printf("Progress: %f seconds, distance %d\n", 0.0, reported);
+
+    #pragma omp parallel num_threads(num_of_threads)
+    {
+    unsigned seed = 2654435761u * (omp_get_thread_num() + 1);
+    int *path = initialize_min_path();
+    int *tmp = initialize_min_path();
+    int *pos = initialize_min_path();
+    int *local_min_path = initialize_min_path();
+    long n, uphill = 0;
+    double sum = 0;
+    move m;
+    memcpy(path, start, num * sizeof(int));
+    memcpy(local_min_path, start, num * sizeof(int));
+    for (n = 0; n < num; ++n)
+	pos[path[n]] = n;
+    int cost = compute_cost(path);
+    int local_min_cost = cost;
+
+    for (n = 0; n < SA_SAMPLES; ++n){
+	random_move(path, pos, &seed, &m);
+	if (m.delta > 0){
+	    sum += m.delta;
+	    ++uphill;
+	}
+    }
+    double t0 = (uphill > 0) ? sum / uphill : 1;
+    double temperature = t0;
+
+    for (n = 0; ; ++n){
+	if (n % SA_CHECK == 0){
+	    double fraction = (omp_get_wtime() - start_time) / time_budget;
+	    if (fraction >= 1)
+		break;
+	    temperature = t0 * neg_exp(SA_COOLING * fraction);
+	    if (local_min_cost < __atomic_load_n(&reported, __ATOMIC_RELAXED)){
+		#pragma omp critical
+		{
+		if (local_min_cost < reported){
+		    reported = local_min_cost;
+		    printf("Progress: %f seconds, distance %d\n", omp_get_wtime() - start_time, reported);
+		}
+		}
+	    }
+	}
+	random_move(path, pos, &seed, &m);
+	if (m.delta <= 0 || (next_rand(&seed) / 4294967296.0) < neg_exp(m.delta / temperature)){
+	    apply_move(path, pos, tmp, &m);
+	    cost += m.delta;
+	    if (cost < local_min_cost){
+		local_min_cost = cost;
+		memcpy(local_min_path, path, num * sizeof(int));
+		update_incumbent(cost);
+	    }
+	}
+    }
+
+    update_incumbent(local_min_cost);
+    #pragma omp barrier
+    update_global(local_min_cost, local_min_path);
+    free(path);
+    free(tmp);
+    free(pos);
+    free(local_min_path);
+    }
+    free(start);
+    free(neighbors);
+}
+
+/* Binary matrices written by tsmconv: the magic, the number of cities as
+ * a 32-bit int, then the weights row by row as 32-bit ints in host byte
+ * order. Anything else is read as text. */
+#define MATRIX_MAGIC "TSM1"
+#define MATRIX_HEADER 8
+
+int is_blank(char c){
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+int is_digit(char c){
+    return c >= '0' && c <= '9';
+}
+
+// first position at or after pos that follows a blank, so no number is cut
+size_t chunk_start(const char *text, size_t size, size_t pos){
+    if (pos == 0)
+	return 0;
+    while (pos < size && !is_blank(text[pos - 1]))
+	++pos;
+    return pos;
+}
+
+size_t count_numbers(const char *text, size_t s, size_t e){
+    size_t count = 0;
+    size_t p;
+    for (p = s; p < e; ++p)
+	if (!is_blank(text[p]) && (p == s || is_blank(text[p - 1])))
+	    ++count;
+    return count;
+}
+
+/* Parses the numbers in text[s, e) as weights k, k + 1, ... of the matrix.
+ * Returns 0, 4 with the weight in *bad if it does not fit in weight_t,
+ * 5 on anything but a number, or 6 with the weight in *bad if it is
+ * negative: the lower bounds assume that no edge costs less than 0. */
+int parse_numbers(const char *text, size_t s, size_t e, size_t k, long *bad){
+    size_t total = (size_t)num * num;
+    size_t p = s;
+    while (p < e){
+	while (p < e && is_blank(text[p]))
+	    ++p;
+	if (p == e)
+	    break;
+	int neg = text[p] == '-';
+	if (neg)
+	    ++p;
+	if (p == e || !is_digit(text[p]))
+	    return 5;
+	long w = 0;
+	while (p < e && is_digit(text[p])){
+	    if (w <= 2147483647)
+		w = w * 10 + (text[p] - '0');
+	    ++p;
+	}
+	if (p < e && !is_blank(text[p]))
+	    return 5;
+	if (neg)
+	    w = -w;
+	if (k < total){
+	    if (w < 0){
+		*bad = w;
+		return 6;
+	    }
+#ifdef WEIGHT16
+	    if (w < 0 || w > WEIGHT_MAX){
+		*bad = w;
+		return 4;
+	    }
+#endif
+	    if (w > 2147483647){
+		*bad = w;
+		return 4;
+	    }
+	    WEIGHT(k / num, k % num) = w;
+	}
+	++k;
+    }
+    return 0;
+}
+
+/* Text matrices are cut into one chunk per thread at blanks. A first pass
+ * counts the numbers in each chunk, so every chunk knows the index of its
+ * first weight, and a second pass parses the chunks in parallel. Numbers
+ * past the num * num weights are ignored. */
+int load_text(const char *text, size_t size, int threads){
+    size_t *start = (size_t *)malloc((threads + 1) * sizeof(size_t));
+    size_t *first = (size_t *)malloc((threads + 1) * sizeof(size_t));
+    int *status = (int *)malloc(threads * sizeof(int));
+    long *bad = (long *)malloc(threads * sizeof(long));
+    int t, res = 0;
+
+    for (t = 0; t < threads; ++t)
+	start[t] = chunk_start(text, size, size / threads * t);
+    start[threads] = size;
+
+    #pragma omp parallel for num_threads(threads)
+    for (t = 0; t < threads; ++t)
+	first[t + 1] = count_numbers(text, start[t], start[t + 1]);
+    first[0] = 0;
+    for (t = 0; t < threads; ++t)
+	first[t + 1] += first[t];
+
+    if (first[threads] < (size_t)num * num){
+	printf("File has %zu weights, %d cities need %zu!\n", first[threads], num, (size_t)num * num);
+	res = 5;
+    }
+    else {
+	#pragma omp parallel for num_threads(threads)
+	for (t = 0; t < threads; ++t)
+	    status[t] = parse_numbers(text, start[t], start[t + 1], first[t], &bad[t]);
+	for (t = 0; t < threads && res == 0; ++t){
+	    res = status[t];
+	    if (res == 4)
+#ifdef WEIGHT16
+		printf("Weight %ld does not fit in 16 bits, build without -DWEIGHT16!\n", bad[t]);
+#else
+		printf("Weight %ld does not fit in an int!\n", bad[t]);
+#endif
+	    else if (res == 6)
+		printf("Weight %ld is negative, weights must be at least 0!\n", bad[t]);
+	    else if (res == 5)
+		printf("File is not a distance matrix!\n");
+	}
+    }
+
+    free(start);
+    free(first);
+    free(status);
+    free(bad);
+    return res;
+}
+
+int load_binary(const char *data, size_t size, int threads){
+    int n;
+    memcpy(&n, data + 4, sizeof(int));
+    if (n != num){
+	printf("File holds %d cities, not %d!\n", n, num);
+	return 5;
+    }
+    if (size < MATRIX_HEADER + (size_t)num * num * sizeof(int)){
+	printf("File is too short for %d cities!\n", num);
+	return 5;
+    }
+
+    const int *row = (const int *)(data + MATRIX_HEADER);
+    int i, res = 0;
+    #pragma omp parallel for num_threads(threads) reduction(max:res)
+    for (i = 0; i < num; ++i){
+	int j;
+	for (j = 0; j < num; ++j){
+	    int w = row[(size_t)i * num + j];
+	    if (w < 0){
+		res = 6;
+		continue;
+	    }
+#ifdef WEIGHT16
+	    if (w > WEIGHT_MAX){
+		res = res > 4 ? res : 4;
+		continue;
+	    }
+#endif
+	    WEIGHT(i, j) = w;
+	}
+    }
+    if (res == 6)
+	printf("A weight is negative, weights must be at least 0!\n");
+#ifdef WEIGHT16
+    if (res == 4)
+	printf("A weight does not fit in 16 bits, build without -DWEIGHT16!\n");
+#endif
+    return res;
+}
+
+/* Maps the file and fills the weights matrix from either format.
+ * Returns 0, or the exit code after printing why the file was refused. */
+int load_weights(int fd, int threads){
+    struct stat st;
+    if (fstat(fd, &st) != 0){
+	printf("File cannot be read!\n");
+	return 2;
+    }
+    size_t size = st.st_size;
+    if (size == 0)
+	return load_text("", 0, threads);
+
+    char *data = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED){
+	printf("File cannot be read!\n");
+	return 2;
+    }
+    posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+
+    int res;
+    if (size >= MATRIX_HEADER && memcmp(data, MATRIX_MAGIC, 4) == 0)
+	res = load_binary(data, size, threads);
+    else
+	res = load_text(data, size, threads);
+    munmap(data, size);
+    return res;
+}
+
+int run(int argc, char *argv[]){
     /****** Start of Sequential Processing ******/
     clock_t program_start = clock();
     double program_start_time = omp_get_wtime();
     /*** Preprocessing ***/
     // Check command line arguments
     
-    if (argc != 4){
-	printf("usage: ptsm x t filename.txt\n");
+    enum { OPT_INTERVAL = 256, OPT_RESUME };
+    static struct option long_options[] = {
+	{ "checkpoint", required_argument, NULL, 'c' },
+	{ "interval", required_argument, NULL, OPT_INTERVAL },
+	{ "resume", no_argument, NULL, OPT_RESUME },
+	{ NULL, 0, NULL, 0 }
+    };
+    int opt, bad_args = 0;
+    int mode = MODE_BB;
+    while ((opt = getopt_long(argc, argv, "c:d:m:T:", long_options, NULL)) != -1){
+	switch (opt){
+	case 'c':
+	    checkpoint_file = optarg;
+	    break;
+	case OPT_INTERVAL:
+	    checkpoint_interval = atof(optarg);
+	    break;
+	case OPT_RESUME:
+	    resume = 1;
+	    break;
+	case 'd':
+	    split_depth = atoi(optarg);
+	    break;
+	case 'T':
+	    time_budget = atof(optarg);
+	    break;
+	case 'm':
+	    for (mode = 0; mode < NUM_MODES; ++mode)
+		if (strcmp(optarg, mode_names[mode]) == 0)
+		    break;
+	    if (mode == NUM_MODES)
+		bad_args = 1;
+	    break;
+	default:
+	    bad_args = 1;
+	}
+    }
+
+    if (checkpoint_file && mode != MODE_BB && mode != MODE_EXHAUSTIVE)
+	bad_args = 1;
+    if (resume && !checkpoint_file)
+	bad_args = 1;
+    if (bad_args || argc - optind != 3){
+	printf("usage: ptsm [-m bb|hk|exhaustive|simd|heur|sa] [-T seconds] [-d depth]\n");
+	printf("            [-c file [--interval seconds] [--resume]] x t filename.txt\n");
 	printf("x is the number of cities\n");
 	printf("t is the number of threads\n");
-	printf("filename.txt is the file that contains the distance matrix\n");
+	printf("filename.txt is the file that contains the distance matrix, as text\n");
+	printf("   or as a binary matrix written by tsmconv\n");
+	printf("-m picks the solver: branch and bound (default), Held-Karp, every ordering\n");
+	printf("   recursively, every ordering iteratively with SIMD evaluation, or\n");
+	printf("   nearest neighbor with 2-opt / Or-opt or simulated annealing (not\n");
+	printf("   exact, for large inputs)\n");
+	printf("   Held-Karp takes at most %d cities\n", HK_MAX_CITIES);
+	printf("seconds is the time budget of simulated annealing (default 1)\n");
+	printf("depth is the number of cities after city 0 split into tasks (default 2);\n");
+	printf("   under mpirun, rank 0 hands out prefixes of that many cities to the\n");
+	printf("   other ranks (build with mpicc -DUSE_MPI)\n");
+	printf("-c (--checkpoint) saves the progress of -m bb or -m exhaustive to file\n");
+	printf("   every --interval seconds (default 60), one done flag per prefix of\n");
+	printf("   depth cities; --resume skips the prefixes file marks as done\n");
 	return 1;
     }
     // Read in weights
-    num = atoi(argv[1]);
-    int num_of_threads = atoi(argv[2]);
-    char *file = argv[3];
-    FILE *fp = fopen(file, "r");
-
-    if (!fp){
-	printf("File cannot be opened!\n");
-	return 2;
+    num = atoi(argv[optind]);
+    int num_of_threads = atoi(argv[optind+1]);
+    char *file = argv[optind+2];
+    if (mode == MODE_HK && num > HK_MAX_CITIES){
+	printf("-m hk handles at most %d cities, not %d!\n", HK_MAX_CITIES, num);
+	return 1;
+    }
+#ifdef USE_MPI
+    if (ranks > 1 && (mode != MODE_BB || checkpoint_file)){
+	if (rank == 0)
+	    printf("Only -m bb without -c runs across MPI ranks!\n");
+	return 1;
     }
+#endif
 
-    weights = (int**) malloc(num * sizeof(int*));
+    // Rows padded to whole cachelines
+    stride = (num * sizeof(weight_t) + 63) / 64 * 64 / sizeof(weight_t);
+    weights = (weight_t*) aligned_block(64, num * stride * sizeof(weight_t));
     if (!weights){
 	printf("Cannot allocate weights matrix!\n");
 	return 3;
     }
+    memset(weights, 0, num * stride * sizeof(weight_t));
 
-    int i, j;
-    for (i = 0; i < num; ++i){
-	weights[i] = (int*) malloc(num * sizeof(int));
-	if (!weights[i]){
-	    printf("Cannot allocate weights matrix on %dth row!\n", i+1);
-	    return 4;
+    // Text or tsmconv binary, parsed by up to t threads
+    int load_status = 2;
+    if (rank == 0){
+	int fd = open(file, O_RDONLY);
+	if (fd < 0)
+	    printf("File cannot be opened!\n");
+	else {
+	    load_status = load_weights(fd, num_of_threads > 0 ? num_of_threads : 1);
+	    close(fd);
 	}
     }
-
-    for (i = 0; i < num; ++i){
-	for (j = 0; j < num; ++j){
-	    fscanf(fp, "%d ", &weights[i][j]);
-	}
-    }
-
-    fclose(fp);
+#ifdef USE_MPI
+    // Rank 0 reads the file, the other ranks get the matrix from it
+    MPI_Bcast(&load_status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (load_status == 0)
+	MPI_Bcast(weights, num * stride * sizeof(weight_t), MPI_BYTE, 0, MPI_COMM_WORLD);
+#endif
+    if (load_status != 0)
+	return load_status;
+    int i;
 
     /*** Find Min Path ***/
     // Initialize global variables
     initialize_cost(&min_cost);
     min_path = initialize_path();
-     
-    // Create private variables
-    int local_min_cost;
-    int *local_min_path;
-    int *local_path;   
+    initialize_bounds();
     clock_t parallel_start;
     clock_t parallel_end;
     double parallel_start_time;
     double parallel_end_time;
 
-    /** Distribute the work among threads by setting the second city to visit **/
-    #pragma omp parallel private(i, j, local_min_cost, local_min_path, local_path) num_threads(num_of_threads)
-    {
-    // Initialize private variables
-    initialize_cost(&local_min_cost);
-    local_min_path = initialize_min_path();
-    local_path = initialize_path();
-
     /****** End of Sequential Processing ******/    
     /****** Start of Parallel Processing ******/
-    #pragma omp single nowait
-    {
     parallel_start = clock();
     parallel_start_time = omp_get_wtime();
+    if (checkpoint_file){
+	int res = solve_frontier(mode, num_of_threads);
+	if (res != 0)
+	    return res;
     }
-
-    #pragma omp for
-    for (i = 1; i < num; ++i){
-	local_path[1] = i;
-	for (j = 1; j < i; ++j)
-	    local_path[1+j] = j;
-        for (j = i+1; j < num; ++j)
-	    local_path[j] = j;
-	permute(local_path, 2, num-1, &local_min_cost, local_min_path);
+    else if (mode == MODE_HK){
+	if (held_karp(num_of_threads) != 0){
+	    printf("Cannot allocate the Held-Karp table for %d cities!\n", num);
+	    return 3;
+	}
     }
-    /****** End of Parallel Processing ******/
-    #pragma omp single nowait
-    {
+    else if (mode == MODE_EXHAUSTIVE)
+	solve_exhaustive(num_of_threads);
+    else if (mode == MODE_SIMD)
+	solve_simd(num_of_threads);
+    else if (mode == MODE_HEUR)
+	solve_heuristic(num_of_threads);
+    else if (mode == MODE_SA)
+	solve_annealing(num_of_threads);
+#ifdef USE_MPI
+    else if (ranks > 1)
+	solve_mpi(num_of_threads);
+#endif
+    else
+	solve_branch_bound(num_of_threads);
     parallel_end = clock();
     parallel_end_time = omp_get_wtime();
-    }
+    /****** End of Parallel Processing ******/
 
     /****** Start of Sequential Processing ******/
 
-    update_global(local_min_cost, local_min_path);
-    free(local_min_path);
-    free(local_path);
-    }
+    // Rank 0 reports for all of them
+    if (rank != 0)
+	return 0;
 
     /*** Output results ***/
     printf("Best path: ");
@@ -184,7 +1634,15 @@ int main(int argc, char *argv[]){
 	printf("%d ", min_path[i]);
     printf("\n");
     printf("Distance: %d\n", min_cost);
+    if (mode == MODE_BB){
+	for (i = 0; i < num_of_threads; ++i)
+	    printf("Thread %d pruned %ld subtrees\n", i, pruned[i]);
+    }
+    free(pruned);
     free(min_path);
+    free(min_out);
+    free(min_two);
+    free(second);
     /****** End of Sequential Processing ******/
     // Output total processing time VS sequential processing time VS parallel processing time
     clock_t program_end = clock();
@@ -205,6 +1663,20 @@ int main(int argc, char *argv[]){
     return 0;
 }
 
+int main(int argc, char *argv[]){
+#ifdef USE_MPI
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    int status = run(argc, argv);
+    MPI_Finalize();
+    return status;
+#else
+    return run(argc, argv);
+#endif
+}
+
 
 
 
@@ -1,9 +1,23 @@
+/* POSIX as well as C99: posix_memalign */
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 int num;
-int **weights;
+/* Distance matrix: one cacheline-aligned block, each row padded to whole
+ * cachelines. Build with -DWEIGHT16 to store 16-bit weights; the choice
+ * is made at compile time, and a build with WEIGHT16 refuses a matrix
+ * whose weights do not fit. */
+#ifdef WEIGHT16
+typedef unsigned short weight_t;
+#define WEIGHT_MAX 65535
+#else
+typedef int weight_t;
+#endif
+weight_t *weights;
+size_t stride;
+#define WEIGHT(i, j) weights[(size_t)(i) * stride + (j)]
 int min_cost = 2147483647;
 int *min_path;
 
@@ -12,7 +26,7 @@ int compute_cost(int *path){
     int cost = 0;
     int i;
     for (i = 0; i < num - 1; ++i)
-	cost += weights[path[i]][path[i+1]];
+	cost += WEIGHT(path[i], path[i+1]);
     return cost;
 }
 
@@ -61,24 +75,25 @@ int main(int argc, char *argv[]){
 	return 2;
     }
 
-    weights = (int**) malloc(num * sizeof(int*));
-    if (!weights){
+    // Rows padded to whole cachelines
+    stride = (num * sizeof(weight_t) + 63) / 64 * 64 / sizeof(weight_t);
+    if (posix_memalign((void **)&weights, 64, num * stride * sizeof(weight_t)) != 0){
 	printf("Cannot allocate weights matrix!\n");
 	return 3;
     }
+    memset(weights, 0, num * stride * sizeof(weight_t));
 
-    int i, j;
-    for (i = 0; i < num; ++i){
-	weights[i] = (int*) malloc(num * sizeof(int));
-	if (!weights[i]){
-	    printf("Cannot allocate weights matrix on %dth row!\n", i+1);
-	    return 4;
-	}
-    }
-
+    int i, j, w;
     for (i = 0; i < num; ++i){
 	for (j = 0; j < num; ++j){
-	    fscanf(fp, "%d ", &weights[i][j]);
+	    fscanf(fp, "%d ", &w);
+#ifdef WEIGHT16
+	    if (w < 0 || w > WEIGHT_MAX){
+		printf("Weight %d does not fit in 16 bits, build without -DWEIGHT16!\n", w);
+		return 4;
+	    }
+#endif
+	    WEIGHT(i, j) = w;
 	}
     }
 
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Converts a text distance matrix to the binary format ptsm maps
+ * directly: the magic, the number of cities as a 32-bit int, then the
+ * weights row by row as 32-bit ints in host byte order. */
+#define MATRIX_MAGIC "TSM1"
+
+int main(int argc, char *argv[]){
+    if (argc != 4){
+	printf("usage: tsmconv x filename.txt filename.bin\n");
+	printf("x is the number of cities\n");
+	printf("filename.txt is the file that contains the distance matrix\n");
+	printf("filename.bin is the binary matrix written for ptsm\n");
+	return 1;
+    }
+    int num = atoi(argv[1]);
+    FILE *in = fopen(argv[2], "r");
+    if (!in){
+	printf("File cannot be opened!\n");
+	return 2;
+    }
+    int *row = (int *)malloc(num * sizeof(int));
+    if (!row){
+	printf("Cannot allocate a row of %d weights!\n", num);
+	return 3;
+    }
+    FILE *out = fopen(argv[3], "wb");
+    if (!out){
+	printf("%s cannot be created!\n", argv[3]);
+	return 2;
+    }
+
+    fwrite(MATRIX_MAGIC, 1, 4, out);
+    fwrite(&num, sizeof(int), 1, out);
+    int i, j;
+    for (i = 0; i < num; ++i){
+	for (j = 0; j < num; ++j){
+	    if (fscanf(in, "%d", &row[j]) != 1){
+		printf("File has fewer than %d weights!\n", num * num);
+		fclose(out);
+		remove(argv[3]);
+		return 5;
+	    }
+	}
+	fwrite(row, sizeof(int), num, out);
+    }
+
+    fclose(in);
+    if (fclose(out) != 0){
+	printf("%s cannot be written!\n", argv[3]);
+	return 2;
+    }
+    free(row);
+    return 0;
+}